@@ -773,7 +773,7 @@ Write_One_AN1_Waypoint(const Waypoint* wpt)
   }
 
 
-  rec->creation_time = rec->modification_time = wpt->GetCreationTime().toTime_t();
+  rec->creation_time = rec->modification_time = wpt->creation_time.toTime_t();
   rec->lat = EncodeOrd(wpt->latitude);
   rec->lon = EncodeOrd(-wpt->longitude);
   rec->serial = serial++;
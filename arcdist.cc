@@ -25,6 +25,7 @@
 #include "filterdefs.h"
 #include "grtcirc.h"
 
+#include <algorithm> // min, max, nth_element
 #include <cmath>
 #include <cstdio>
 #include <cstdlib> // strtod
@@ -34,60 +35,184 @@
 
 #define BADVAL 999999
 
-void ArcDistanceFilter::arcdist_arc_disp_wpt_cb(const Waypoint* arcpt2)
+/* Unit vector pointing at lat/lon (in degrees). */
+static void arcdist_unit_vec(double lat, double lon, double v[3])
 {
-  static Waypoint* arcpt1 = nullptr;
-  double prjlat, prjlon, frac;
+  v[0] = cos(RAD(lat)) * cos(RAD(lon));
+  v[1] = cos(RAD(lat)) * sin(RAD(lon));
+  v[2] = sin(RAD(lat));
+}
 
-  if (arcpt2 && arcpt2->latitude != BADVAL && arcpt2->longitude != BADVAL &&
-      (ptsopt || (arcpt1 &&
-                  (arcpt1->latitude != BADVAL && arcpt1->longitude != BADVAL)))) {
-    foreach (Waypoint* waypointp, *global_waypoint_list) {
-      double dist;
-      extra_data* ed;
-      if (waypointp->extra_data) {
-        ed = (extra_data*) waypointp->extra_data;
-      } else {
-        ed = (extra_data*) xcalloc(1, sizeof(*ed));
-        ed->distance = BADVAL;
+/*
+ * Grow lo/hi to take in the great circle arc from a to b.  An arc of at
+ * most 90 degrees lies inside the triangle formed by its endpoints and
+ * the intersection of the tangents at them; longer arcs are halved.
+ */
+static void arcdist_arc_bounds(const double a[3], const double b[3], double lo[3], double hi[3], int depth)
+{
+  const double cosang = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  double mid[3] = { a[0] + b[0], a[1] + b[1], a[2] + b[2] };
+
+  if (cosang < 0.1) {
+    const double len = sqrt(mid[0] * mid[0] + mid[1] * mid[1] + mid[2] * mid[2]);
+    if ((depth > 4) || (len < 1e-9)) {
+      /* (Nearly) antipodal; any great circle will do, so take it all. */
+      for (int k = 0; k < 3; k++) {
+        lo[k] = -1.0;
+        hi[k] = 1.0;
       }
-      if (ed->distance == BADVAL || projectopt || ed->distance >= pos_dist) {
-        if (ptsopt) {
-          dist = gcdist(RAD(arcpt2->latitude),
-                        RAD(arcpt2->longitude),
-                        RAD(waypointp->latitude),
-                        RAD(waypointp->longitude));
-          prjlat =  arcpt2->latitude;
-          prjlon = arcpt2->longitude;
-          frac = 1.0;
-        } else {
-          dist = linedistprj(arcpt1->latitude,
-                             arcpt1->longitude,
-                             arcpt2->latitude,
-                             arcpt2->longitude,
-                             waypointp->latitude,
-                             waypointp->longitude,
-                             &prjlat, &prjlon, &frac);
-        }
+      return;
+    }
+    for (double& c : mid) {
+      c /= len;
+    }
+    arcdist_arc_bounds(a, mid, lo, hi, depth + 1);
+    arcdist_arc_bounds(mid, b, lo, hi, depth + 1);
+    return;
+  }
+
+  for (int k = 0; k < 3; k++) {
+    const double tangent = mid[k] / (1.0 + cosang);
+    lo[k] = std::min({lo[k], a[k], b[k], tangent});
+    hi[k] = std::max({hi[k], a[k], b[k], tangent});
+  }
+}
+
+quint64 ArcDistanceFilter::grid_key(const int cell[3]) const
+{
+  return (static_cast<quint64>(cell[0]) << (2 * kGridBits)) |
+         (static_cast<quint64>(cell[1]) << kGridBits) |
+         static_cast<quint64>(cell[2]);
+}
+
+int ArcDistanceFilter::grid_cell(double c) const
+{
+  const int cell = floor((c + 1.0) / grid_size);
+  const int max_cell = (1 << kGridBits) - 1;
+  return (cell < 0) ? 0 : (cell > max_cell) ? max_cell : cell;
+}
+
+/*
+ * Bucket the arc segments in a grid of earth-centered cubes.  Each
+ * segment is entered in every cube its bounding box, grown by the
+ * search distance, touches.  A waypoint then only needs to be tested
+ * against the segments in its own cube.  Segments so long that they
+ * would touch too many cubes are tested against every waypoint.
+ */
+void ArcDistanceFilter::arcdist_index_segments()
+{
+  /* Work on the unit sphere; a chord is never longer than its arc. */
+  const double reach = pos_dist / radtomiles(1.0) * 1.001;
+  const double min_size = 16.0 / radtometers(1.0);
+
+  /* Size the cells to a typical segment; a few long jumps shouldn't
+   * coarsen the whole grid. */
+  QVector<double> lens;
+  lens.reserve(segs.size());
+  for (const auto& seg : qAsConst(segs)) {
+    double a[3], b[3];
+    arcdist_unit_vec(seg.lat1, seg.lon1, a);
+    arcdist_unit_vec(seg.lat2, seg.lon2, b);
+    lens.append(sqrt((a[0] - b[0]) * (a[0] - b[0]) +
+                     (a[1] - b[1]) * (a[1] - b[1]) +
+                     (a[2] - b[2]) * (a[2] - b[2])));
+  }
+  double typical_len = 0.0;
+  if (!lens.isEmpty()) {
+    auto median = lens.begin() + lens.size() / 2;
+    std::nth_element(lens.begin(), median, lens.end());
+    typical_len = *median;
+  }
+  grid_size = std::max({reach, min_size, typical_len});
+
+  for (int i = 0; i < segs.size(); i++) {
+    const arc_seg& seg = segs.at(i);
+    double a[3], b[3];
+    arcdist_unit_vec(seg.lat1, seg.lon1, a);
+    arcdist_unit_vec(seg.lat2, seg.lon2, b);
+    double lo[3] = { a[0], a[1], a[2] };
+    double hi[3] = { a[0], a[1], a[2] };
+    arcdist_arc_bounds(a, b, lo, hi, 0);
+
+    int first[3], last[3];
+    double ncells = 1.0;
+    for (int k = 0; k < 3; k++) {
+      first[k] = grid_cell(lo[k] - reach);
+      last[k] = grid_cell(hi[k] + reach);
+      ncells *= last[k] - first[k] + 1;
+    }
+    if (ncells > kMaxCellsPerSegment) {
+      seg_oversize.append(i);
+      continue;
+    }
 
-        /* convert radians to float point statute miles */
-        dist = radtomiles(dist);
-
-        if (ed->distance > dist) {
-          ed->distance = dist;
-          if (projectopt) {
-            ed->prjlatitude = prjlat;
-            ed->prjlongitude = prjlon;
-            ed->frac = frac;
-            ed->arcpt1 = arcpt1;
-            ed->arcpt2 = const_cast<Waypoint*>(arcpt2);
-          }
+    int cell[3];
+    for (cell[0] = first[0]; cell[0] <= last[0]; cell[0]++) {
+      for (cell[1] = first[1]; cell[1] <= last[1]; cell[1]++) {
+        for (cell[2] = first[2]; cell[2] <= last[2]; cell[2]++) {
+          seg_grid[grid_key(cell)].append(i);
         }
-        waypointp->extra_data = ed;
       }
     }
   }
-  arcpt1 = const_cast<Waypoint*>(arcpt2);
+}
+
+void ArcDistanceFilter::arcdist_test_segment(extra_data& ed, const arc_seg& seg, const Waypoint* waypointp)
+{
+  double dist, prjlat, prjlon, frac;
+
+  if (ed.distance == BADVAL || projectopt || ed.distance >= pos_dist) {
+    if (ptsopt) {
+      dist = gcdist(RAD(seg.lat2),
+                    RAD(seg.lon2),
+                    RAD(waypointp->latitude),
+                    RAD(waypointp->longitude));
+      prjlat = seg.lat2;
+      prjlon = seg.lon2;
+      frac = 1.0;
+    } else {
+      dist = linedistprj(seg.lat1,
+                         seg.lon1,
+                         seg.lat2,
+                         seg.lon2,
+                         waypointp->latitude,
+                         waypointp->longitude,
+                         &prjlat, &prjlon, &frac);
+    }
+
+    /* convert radians to float point statute miles */
+    dist = radtomiles(dist);
+
+    if (ed.distance > dist) {
+      ed.distance = dist;
+      if (projectopt) {
+        ed.prjlatitude = prjlat;
+        ed.prjlongitude = prjlon;
+        ed.frac = frac;
+        ed.arcpt1 = seg.arcpt1;
+        ed.arcpt2 = seg.arcpt2;
+      }
+    }
+  }
+}
+
+void ArcDistanceFilter::arcdist_arc_disp_wpt_cb(const Waypoint* arcpt2)
+{
+  static const Waypoint* arcpt1 = nullptr;
+
+  if (arcpt2 && arcpt2->latitude != BADVAL && arcpt2->longitude != BADVAL &&
+      (ptsopt || (arcpt1 &&
+                  (arcpt1->latitude != BADVAL && arcpt1->longitude != BADVAL)))) {
+    arc_seg seg;
+    seg.lat1 = ptsopt ? arcpt2->latitude : arcpt1->latitude;
+    seg.lon1 = ptsopt ? arcpt2->longitude : arcpt1->longitude;
+    seg.lat2 = arcpt2->latitude;
+    seg.lon2 = arcpt2->longitude;
+    seg.arcpt1 = arcpt1;
+    seg.arcpt2 = arcpt2;
+    segs.append(seg);
+  }
+  arcpt1 = arcpt2;
 }
 
 void ArcDistanceFilter::arcdist_arc_disp_hdr_cb(const route_head*)
@@ -101,6 +226,10 @@ void ArcDistanceFilter::process()
   WayptFunctor<ArcDistanceFilter> arcdist_arc_disp_wpt_cb_f(this, &ArcDistanceFilter::arcdist_arc_disp_wpt_cb);
   RteHdFunctor<ArcDistanceFilter> arcdist_arc_disp_hdr_cb_f(this, &ArcDistanceFilter::arcdist_arc_disp_hdr_cb);
 
+  segs.clear();
+  seg_grid.clear();
+  seg_oversize.clear();
+
   if (arcfileopt) {
     int fileline = 0;
     char* line;
@@ -145,54 +274,106 @@ void ArcDistanceFilter::process()
     track_disp_all(arcdist_arc_disp_hdr_cb_f, nullptr, arcdist_arc_disp_wpt_cb_f);
   }
 
+  /* Without any usable arc there is nothing to measure against. */
+  if (segs.isEmpty()) {
+    if (global_opts.verbose_status > 0) {
+      printf(MYNAME "-arc: 0 waypoint(s) removed.\n");
+    }
+    return;
+  }
+
+  /*
+   * Projecting the excluded points means we need the nearest segment
+   * even for points far from the arc, so we must look at all of them.
+   */
+  const bool use_index = !(projectopt && exclopt);
+  if (use_index) {
+    arcdist_index_segments();
+  }
+
+  extra_data unset{};
+  unset.distance = BADVAL;
+  QVector<extra_data> eds(global_waypoint_list->count(), unset);
+  int idx = 0;
+  foreach (Waypoint* waypointp, *global_waypoint_list) {
+    extra_data& ed = eds[idx++];
+    if (!use_index) {
+      for (const auto& seg : qAsConst(segs)) {
+        arcdist_test_segment(ed, seg, waypointp);
+      }
+      continue;
+    }
+
+    double v[3];
+    arcdist_unit_vec(waypointp->latitude, waypointp->longitude, v);
+    const int cell[3] = { grid_cell(v[0]), grid_cell(v[1]), grid_cell(v[2]) };
+    const QVector<int> nearby = seg_grid.value(grid_key(cell));
+
+    /* Visit the candidates in arc order so ties resolve as before. */
+    int n = 0;
+    int o = 0;
+    while (n < nearby.size() || o < seg_oversize.size()) {
+      int i;
+      if (o >= seg_oversize.size() ||
+          (n < nearby.size() && nearby.at(n) < seg_oversize.at(o))) {
+        i = nearby.at(n++);
+      } else {
+        i = seg_oversize.at(o++);
+      }
+      arcdist_test_segment(ed, segs.at(i), waypointp);
+    }
+  }
+
   unsigned removed = 0;
+  idx = 0;
   foreach (Waypoint* wp, *global_waypoint_list) {
-    extra_data* ed = (extra_data*) wp->extra_data;
-    wp->extra_data = nullptr;
-    if (ed) {
-      if ((ed->distance >= pos_dist) == (exclopt == nullptr)) {
-        waypt_del(wp);
-        delete wp;
-        removed++;
-      } else if (projectopt) {
-        wp->longitude = ed->prjlongitude;
-        wp->latitude = ed->prjlatitude;
-        wp->route_priority = 1;
-        if (!arcfileopt &&
-            (ed->arcpt2->altitude != unknown_alt) &&
-            (ptsopt || (ed->arcpt1->altitude != unknown_alt))) {
-          /* Interpolate altitude */
-          if (ptsopt) {
-            wp->altitude = ed->arcpt2->altitude;
-          } else {
-            wp->altitude = ed->arcpt1->altitude +
-                           ed->frac * (ed->arcpt2->altitude - ed->arcpt1->altitude);
-          }
-        }
-        if (trkopt &&
-            (ed->arcpt2->GetCreationTime().isValid()) &&
-            (ptsopt || (ed->arcpt1->GetCreationTime().isValid()))) {
-          /* Interpolate time */
-          if (ptsopt) {
-            wp->SetCreationTime(ed->arcpt2->GetCreationTime());
-          } else {
-            // Apply the multiplier to the difference between the times
-            // of the two points.   Add that to the first for the
-            // interpolated time.
-            int scaled_time = ed->frac *
-                              ed->arcpt1->GetCreationTime().msecsTo(ed->arcpt2->GetCreationTime());
-            QDateTime new_time(ed->arcpt1->GetCreationTime().addMSecs(scaled_time));
-            wp->SetCreationTime(new_time);
-          }
+    const extra_data& ed = eds.at(idx++);
+    if ((ed.distance >= pos_dist) == (exclopt == nullptr)) {
+      wp->wpt_flags.marked_for_deletion = 1;
+      removed++;
+    } else if (projectopt) {
+      wp->longitude = ed.prjlongitude;
+      wp->latitude = ed.prjlatitude;
+      wp->route_priority = 1;
+      if (!arcfileopt &&
+          (ed.arcpt2->altitude != unknown_alt) &&
+          (ptsopt || (ed.arcpt1->altitude != unknown_alt))) {
+        /* Interpolate altitude */
+        if (ptsopt) {
+          wp->altitude = ed.arcpt2->altitude;
+        } else {
+          wp->altitude = ed.arcpt1->altitude +
+                         ed.frac * (ed.arcpt2->altitude - ed.arcpt1->altitude);
         }
-        if (global_opts.debug_level >= 1) {
-          warning("Including waypoint %s at dist:%f lat:%f lon:%f\n",
-                  qPrintable(wp->shortname), ed->distance, wp->latitude, wp->longitude);
+      }
+      if (trkopt &&
+          (ed.arcpt2->creation_time.isValid()) &&
+          (ptsopt || (ed.arcpt1->creation_time.isValid()))) {
+        /* Interpolate time */
+        if (ptsopt) {
+          wp->SetCreationTime(ed.arcpt2->GetCreationTime());
+        } else {
+          // Apply the multiplier to the difference between the times
+          // of the two points.   Add that to the first for the
+          // interpolated time.
+          int scaled_time = ed.frac *
+                            ed.arcpt1->creation_time.msecsTo(ed.arcpt2->creation_time);
+          QDateTime new_time(ed.arcpt1->GetCreationTime().addMSecs(scaled_time));
+          wp->SetCreationTime(new_time);
         }
       }
-      xfree(ed);
+      if (global_opts.debug_level >= 1) {
+        warning("Including waypoint %s at dist:%f lat:%f lon:%f\n",
+                qPrintable(wp->shortname), ed.distance, wp->latitude, wp->longitude);
+      }
     }
   }
+  waypt_del_marked();
+
+  segs.clear();
+  seg_grid.clear();
+  seg_oversize.clear();
+
   if (global_opts.verbose_status > 0) {
     printf(MYNAME "-arc: %u waypoint(s) removed.\n", removed);
   }
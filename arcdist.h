@@ -22,6 +22,10 @@
 #ifndef ARCDIST_H_INCLUDED_
 #define ARCDIST_H_INCLUDED_
 
+#include <QtCore/QHash>     // for QHash
+#include <QtCore/QVector>   // for QVector
+#include <QtCore/QtGlobal>  // for quint64
+
 #include "defs.h"    // for ARG_NOMINMAX, ARGTYPE_BOOL, Waypoint (ptr only)
 #include "filter.h"  // for Filter
 
@@ -51,9 +55,25 @@ private:
     double distance;
     double prjlatitude, prjlongitude;
     double frac;
-    Waypoint* arcpt1, * arcpt2;
+    const Waypoint* arcpt1, * arcpt2;
   } extra_data;
 
+  /* One segment of the arc; with the points option just its vertex. */
+  typedef struct {
+    double lat1, lon1;
+    double lat2, lon2;
+    const Waypoint* arcpt1, * arcpt2;
+  } arc_seg;
+
+  /* Each axis of the segment grid gets kGridBits of the cell key. */
+  static constexpr int kGridBits = 20;
+  static constexpr int kMaxCellsPerSegment = 4096;
+
+  QVector<arc_seg> segs;
+  QHash<quint64, QVector<int>> seg_grid;
+  QVector<int> seg_oversize;
+  double grid_size;
+
   arglist_t args[8] = {
     {
       "file", &arcfileopt,  "File containing vertices of arc",
@@ -86,6 +106,10 @@ private:
     ARG_TERMINATOR
   };
 
+  quint64 grid_key(const int cell[3]) const;
+  int grid_cell(double c) const;
+  void arcdist_index_segments();
+  void arcdist_test_segment(extra_data& ed, const arc_seg& seg, const Waypoint* waypointp);
   void arcdist_arc_disp_wpt_cb(const Waypoint* arcpt2);
   void arcdist_arc_disp_hdr_cb(const route_head*);
 
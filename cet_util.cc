@@ -24,6 +24,7 @@
 #include "cet_util.h"
 #include "src/core/logging.h"
 #include <QtCore/QDebug>
+#include <QtCore/QHash>
 #include <QtCore/QTextCodec>
 #include <cstdlib> // qsort
 
@@ -41,6 +42,13 @@ static int cet_cs_alias_ct = 0;
 static int cet_cs_vec_ct = 0;
 static int cet_output = 0;
 
+/*
+ * Output conversion rewrites the format specific strings in place.  The
+ * original chains are parked here, keyed by their owner, until
+ * cet_restore_strings puts them back after the write.
+ */
+static QHash<const Waypoint*, format_specific_data*> cet_output_saved;
+
 /* %%% fixed inbuild character sets %%% */
 
 #include "cet/ansi_x3_4_1968.h"
@@ -378,12 +386,23 @@ cet_convert_waypt(const Waypoint* wpt)
 {
   Waypoint* w = const_cast<Waypoint*>(wpt);
 
-  if ((cet_output == 0) && (w->wpt_flags.cet_converted != 0)) {
-    return;
+  if (cet_output != 0) {
+    /* Only chains holding convertible strings need to be preserved. */
+    format_specific_data* fs = wpt->fs;
+    while ((fs != nullptr) && (fs->convert == nullptr)) {
+      fs = fs->next;
+    }
+    if ((fs == nullptr) || cet_output_saved.contains(wpt)) {
+      return;
+    }
+    cet_output_saved.insert(wpt, fs_chain_copy(wpt->fs));
+  } else {
+    if (w->wpt_flags.cet_converted != 0) {
+      return;
+    }
+    w->wpt_flags.cet_converted = 1;
   }
 
-  w->wpt_flags.cet_converted = 1;
-
   format_specific_data* fs = wpt->fs;
   while (fs != nullptr) {
     if (fs->convert != nullptr) {
@@ -400,11 +419,9 @@ cet_convert_route_hdr(const route_head* route)
 {
   route_head* rte = const_cast<route_head*>(route);
 
-  if ((cet_output == 0) && (rte->cet_converted != 0)) {
-    return;
+  if (cet_output == 0) {
+    rte->cet_converted = 1;
   }
-
-  rte->cet_converted = 1;
 }
 
 /* cet_convert_route_tlr: internal used within cet_convert_strings process */
@@ -466,3 +483,42 @@ cet_convert_strings(const cet_cs_vec_t* source, const cet_cs_vec_t* target, cons
     printf(", done.\n");
   }
 }
+
+/* cet_restore_waypt: internal used within cet_restore_strings process */
+
+static void
+cet_restore_waypt(const Waypoint* wpt)
+{
+  auto it = cet_output_saved.find(wpt);
+  if (it != cet_output_saved.end()) {
+    Waypoint* w = const_cast<Waypoint*>(wpt);
+    fs_chain_destroy(w->fs);
+    w->fs = it.value();
+    cet_output_saved.erase(it);
+  }
+}
+
+/* %%% cet_restore_strings (public) %%%
+ *
+ * - Undo an output conversion done by cet_convert_strings -
+ *
+ * Only the format specific data is touched by an output conversion;
+ * everything else is encoded by the writers through global_opts.codec. */
+
+void
+cet_restore_strings()
+{
+  if (cet_output_saved.isEmpty()) {
+    return;
+  }
+
+  waypt_disp_all(cet_restore_waypt);
+  route_disp_all(nullptr, nullptr, cet_restore_waypt);
+  track_disp_all(nullptr, nullptr, cet_restore_waypt);
+
+  /* whatever is left belonged to points the writer deleted */
+  for (auto fs : qAsConst(cet_output_saved)) {
+    fs_chain_destroy(fs);
+  }
+  cet_output_saved.clear();
+}
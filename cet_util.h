@@ -55,6 +55,7 @@ const char* cet_convert_string(const QString& str);
 
 void cet_convert_init(const QString& cs_name, int force);
 void cet_convert_strings(const cet_cs_vec_t* source, const cet_cs_vec_t* target, const char* format);
+void cet_restore_strings();
 void cet_convert_deinit();
 
 #endif  // CET_UTIL_H_INCLUDED_
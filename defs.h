@@ -49,7 +49,7 @@
 #include "inifile.h"            // for inifile_t
 #include "gbfile.h"             // doesn't really belong here, but is missing elsewhere.
 #include "session.h"            // for session_t
-#include "src/core/datetime.h"  // for DateTime
+#include "src/core/datetime.h"  // for DateTime, PackedDateTime
 #include "src/core/optional.h"  // for optional
 
 
@@ -398,7 +398,8 @@ public:
     geoidheight(0),
     depth(0),
     is_split(0),
-    new_trkseg(0) {}
+    new_trkseg(0),
+    marked_for_deletion(0) {}
   unsigned int shortname_is_synthetic:1;
   unsigned int cet_converted:1;		/* strings are converted to UTF8; interesting only for input */
   unsigned int fmt_use:2;			/* lightweight "extra data" */
@@ -415,6 +416,7 @@ public:
   */
   unsigned int is_split:1;		/* the waypoint represents a split */
   unsigned int new_trkseg:1;		/* True if first in new trkseg. */
+  unsigned int marked_for_deletion:1;	/* True if a filter has scheduled this point for deletion. */
 
 };
 
@@ -515,7 +517,11 @@ public:
   wp_flags wpt_flags;
   QString icon_descr;
 
-  gpsbabel::DateTime creation_time;
+  /*
+   * Kept packed since there is one per point; GetCreationTime() gives
+   * the full DateTime.
+   */
+  gpsbabel::PackedDateTime creation_time;
 
   /*
    * route priority is for use by the simplify filter.  If we have
@@ -585,11 +591,17 @@ public:
   // FIXME: Generally it is inefficient to use an element pointer or reference to define the element to be deleted, use iterator instead,
   //        and/or implement pop_back() a.k.a. removeLast(), and/or pop_front() a.k.a. removeFirst().
   void del_rte_waypt(Waypoint* wpt);
+  // Remove and delete every waypoint with wpt_flags.marked_for_deletion set,
+  // in a single pass.  Prefer marking and compacting once over calling
+  // waypt_del() or del_rte_waypt() in a loop.
+  int waypt_del_marked();
+  int del_marked_rte_wpts();
   void waypt_compute_bounds(bounds* bounds) const;
   Waypoint* find_waypt_by_name(const QString& name) const;
   void flush(); // a.k.a. clear()
   void copy(WaypointList** dst) const;
   void restore(WaypointList* src);
+  void splice(WaypointList* src); // move src's waypoints to our end
   void swap(WaypointList& other);
   void sort(Compare cmp);
   template <typename T>
@@ -614,6 +626,9 @@ public:
   using QList<Waypoint*>::front; // a.k.a. first()
   using QList<Waypoint*>::rbegin;
   using QList<Waypoint*>::rend;
+
+private:
+  int del_marked(bool keep_trkseg);
 };
 
 const global_trait* get_traits();
@@ -621,6 +636,7 @@ void waypt_init();
 //void update_common_traits(const Waypoint* wpt);
 void waypt_add(Waypoint* wpt);
 void waypt_del(Waypoint* wpt);
+void waypt_del_marked();
 unsigned int waypt_count();
 void waypt_disp(const Waypoint* wpt);
 void waypt_status_disp(int total_ct, int myct);
@@ -751,10 +767,12 @@ public:
   void add_wpt(route_head* rte, Waypoint* wpt, bool synth, const QString& namepart, int number_digits);
   // FIXME: Generally it is inefficient to use an element pointer or reference to define the insertion point, use iterator instead.
   void del_wpt(route_head* rte, Waypoint* wpt);
+  void del_marked_wpts(route_head* rte, bool keep_trkseg = true);
   void common_disp_session(const session_t* se, route_hdr rh, route_trl rt, waypt_cb wc);
   void flush(); // a.k.a. clear()
   void copy(RouteList** dst) const;
   void restore(RouteList* src);
+  void splice(RouteList* src); // move src's routes to our end
   void swap(RouteList& other);
   void sort(Compare cmp);
   template <typename T1, typename T2, typename T3>
@@ -808,6 +826,8 @@ void route_add_wpt(route_head* rte, Waypoint* wpt, const QString& namepart = "RP
 void track_add_wpt(route_head* rte, Waypoint* wpt, const QString& namepart = "RPT", int number_digits = 3);
 void route_del_wpt(route_head* rte, Waypoint* wpt);
 void track_del_wpt(route_head* rte, Waypoint* wpt);
+void route_del_marked_wpts(route_head* rte);
+void track_del_marked_wpts(route_head* rte);
 //void route_disp(const route_head* rte, waypt_cb); /* template */
 void route_disp(const route_head* rte, std::nullptr_t /* waypt_cb */); /* override to catch nullptr */
 //void route_disp_all(route_hdr, route_trl, waypt_cb); /* template */
@@ -828,6 +848,13 @@ void track_restore(RouteList* head_bak);
 void track_swap(RouteList& other);
 void track_sort(RouteList::Compare cmp);
 computed_trkdata track_recompute(const route_head* trk);
+class Filter;
+void track_stream_begin(route_hdr rh, route_trl rt, waypt_cb wc, const QList<Filter*>& filters);
+bool track_stream_open();
+void track_stream_release(route_head* trk, int count);
+void track_stream_insert(Waypoint* wpt);
+void track_stream_end();
+void track_stream_add_bounds(bounds* bounds);
 
 template <typename T>
 void
@@ -1035,6 +1062,29 @@ typedef struct position_ops {
 
 #define NULL_POS_OPS { 0, 0, 0, 0, 0, 0, }
 
+/*
+ * Format capabilities for streaming conversion of tracks.
+ *
+ * A reader that can stream releases finished trackpoints with
+ * track_stream_release() while it reads; rd_capable tells whether it can
+ * do so with the options in effect.  Released points must not carry
+ * format specific data that needs character set conversion.
+ *
+ * A writer that can stream takes the tracks through the usual track
+ * callbacks while the input is read, after wr_begin.  The file is
+ * written later by the usual wr_init, write and wr_deinit, with the
+ * tracks taken so far in place of those in the track list that come
+ * first; track_stream_add_bounds() supplies their extent.
+ */
+typedef struct stream_ops {
+  bool (*rd_capable)();
+
+  ff_write wr_begin;
+  route_hdr wr_trk_hdr;
+  route_trl wr_trk_tlr;
+  waypt_cb wr_trk_wpt;
+} stream_ops_t;
+
 /*
  *  Describe the file format to the caller.
  */
@@ -1053,6 +1103,7 @@ typedef struct ff_vecs {
   int fixed_encode;
   position_ops_t position_ops;
   const char* name;		/* dyn. initialized by find_vec */
+  stream_ops_t stream_ops;	/* optional, left out by most formats */
 } ff_vecs_t;
 
 typedef struct style_vecs {
@@ -417,7 +417,7 @@ destinator_trkpt_disp(const Waypoint* wpt)
   }
 
   if (wpt->creation_time.isValid()) {
-    const time_t ct = wpt->GetCreationTime().toTime_t();
+    const time_t ct = wpt->creation_time.toTime_t();
     struct tm tm = *gmtime(&ct);
     tm.tm_mon += 1;
     tm.tm_year -= 100;
@@ -33,14 +33,12 @@
 /*
  * Decide whether to keep or toss this point.
  */
-void DiscardFilter::fix_process_wpt(const Waypoint* wpt)
+bool DiscardFilter::discard_wpt(const Waypoint* waypointp) const
 {
   int del = 0;
   int delh = 0;
   int delv = 0;
 
-  Waypoint* waypointp = const_cast<Waypoint*>(wpt);
-
   if ((hdopf >= 0.0) && (waypointp->hdop > hdopf)) {
     delh = 1;
   }
@@ -87,7 +85,14 @@ void DiscardFilter::fix_process_wpt(const Waypoint* wpt)
     del = 1;
   }
 
-  if (del) {
+  return del;
+}
+
+void DiscardFilter::fix_process_wpt(const Waypoint* wpt)
+{
+  Waypoint* waypointp = const_cast<Waypoint*>(wpt);
+
+  if (discard_wpt(waypointp)) {
     switch (what) {
     case wptdata:
       waypt_del(waypointp);
@@ -131,6 +136,11 @@ void DiscardFilter::process()
 
 }
 
+bool DiscardFilter::stream_point(Waypoint* wpt)
+{
+  return !discard_wpt(wpt);
+}
+
 void DiscardFilter::init()
 {
   if (hdopopt) {
@@ -37,6 +37,11 @@ public:
   }
   void init() override;
   void process() override;
+  bool stream_capable() override
+  {
+    return true;
+  }
+  bool stream_point(Waypoint* wpt) override;
 
 private:
   char* hdopopt = nullptr;
@@ -120,6 +125,7 @@ private:
     ARG_TERMINATOR
   };
 
+  bool discard_wpt(const Waypoint* waypointp) const;
   void fix_process_wpt(const Waypoint* wpt);
   void fix_process_head(const route_head* trk);
 
@@ -19,12 +19,15 @@
 
  */
 
-#include <cstdio>               // for sprintf
-#include <cstdlib>              // for qsort
-#include <cstring>              // for memset, strncpy
+#include <algorithm>            // for stable_sort
+#include <cmath>                // for fabs, floor, fma, isfinite, signbit
+#include <cstdio>               // for snprintf
 
+#include <QtCore/QByteArray>    // for QByteArray, qstrnlen
 #include <QtCore/QDateTime>     // for QDateTime
-#include <QtCore/QtGlobal>      // for foreach
+#include <QtCore/QHash>         // for QHash
+#include <QtCore/QVector>       // for QVector
+#include <QtCore/QtGlobal>      // for foreach, qAsConst, qint64
 
 #include "defs.h"
 #include "filterdefs.h"
@@ -34,61 +37,66 @@
 
 #if FILTERS_ENABLED
 
-DuplicateFilter::btree_node* DuplicateFilter::addnode(btree_node* tree, btree_node* newnode, btree_node** oldnode)
+/*
+ * Reduce a coordinate to an integer that is equal for two values exactly
+ * when printf("%11.3f") of them gives the same text: the magnitude in
+ * thousandths, rounded half to even from the exact binary value just as
+ * printf does, with the sign in the low bit so that "-0.000" and "0.000"
+ * stay distinct.  The error of the scaling multiply is recovered exactly
+ * with fma() so halfway cases are decided correctly.  Returns false for
+ * values (NaNs, huge numbers) that have to go through printf.
+ */
+bool DuplicateFilter::coord_key(double d, qint64* key)
 {
-  btree_node* last = nullptr;
-
-  if (*oldnode) {
-    *oldnode = nullptr;
-  }
-
-  if (!tree) {
-    return (newnode);
+  if (!std::isfinite(d) || std::fabs(d) >= 1.0e12) {
+    return false;
   }
-
-  btree_node* tmp = tree;
-
-  while (tmp) {
-    last = tmp;
-    if (newnode->data < tmp->data) {
-      tmp = tmp->right;
-    } else if (newnode->data > tmp->data) {
-      tmp = tmp->left;
-    } else {
-      if (oldnode) {
-        *oldnode = tmp;
-      }
-      return (nullptr);
-    }
+  const double a = std::fabs(d);
+  const double ip = std::floor(a);
+  const double frac = a - ip;
+  const double p = frac * 1000.0;
+  const double err = std::fma(frac, 1000.0, -p);
+  const double pfloor = std::floor(p);
+  const double r = p - pfloor;
+  auto q = static_cast<qint64>(pfloor);
+  if ((r > 0.5) || ((r == 0.5) && ((err > 0.0) || ((err == 0.0) && (q & 1))))) {
+    q++;
   }
-
-  if (newnode->data < last->data) {
-    last->right = newnode;
-  } else {
-    last->left = newnode;
-  }
-
-  return (tree);
+  const qint64 mag = static_cast<qint64>(ip) * 1000 + q;
+  *key = (mag << 1) | (std::signbit(d) ? 1 : 0);
+  return true;
 }
 
-void DuplicateFilter::free_tree(btree_node* tree)
+DuplicateFilter::dupe_key DuplicateFilter::make_key(const Waypoint* waypointp) const
 {
-  if (tree->left) {
-    free_tree(tree->left);
+  dupe_key key;
+
+  if (snopt) {
+    key.shortname = waypointp->shortname.toLatin1();
+    key.shortname.truncate(qstrnlen(key.shortname.constData(), 31));
   }
-  if (tree->right) {
-    free_tree(tree->right);
+
+  if (lcopt) {
+    /* The degrees2ddmm stuff is a feeble attempt to
+     * get everything rounded the same way in a precision
+     * that's "close enough" for determining duplicates.
+     */
+    const double lat = degrees2ddmm(waypointp->latitude);
+    const double lon = degrees2ddmm(waypointp->longitude);
+    if (!coord_key(lat, &key.lat) || !coord_key(lon, &key.lon)) {
+      char buf[64];
+      snprintf(buf, sizeof(buf), "%11.3f%11.3f", lat, lon);
+      key.lat = key.lon = 0;
+      key.text = buf;
+    }
   }
-  xfree(tree);
+
+  return key;
 }
 
 /*
 
-It looks odd that we have different comparisons for date and index.
-	If exported if a < b return 1
-	if index    if a < b return -1
-
-The reason is that we want to sort in reverse order by date, but forward
+We want to visit the points in reverse order by export date, but forward
 order by index.  So if we have four records:
 
     date      index
@@ -97,7 +105,7 @@ order by index.  So if we have four records:
     June 25    2
     June 24    3
 
-we want to sort them like this:
+we want to visit them like this:
 
     date      index
     June 25    1
@@ -108,122 +116,68 @@ we want to sort them like this:
 Thus, the first point we come across is the latest point, but if we
 have two points with the same export date/time, we will first see the
 one with the smaller index (i.e. the first of those two points that we
-came across while importing waypoints.)
+came across while importing waypoints.)  A stable sort on the date alone
+does exactly that.
 
-In the (common) case that we have no exported dates, the dates will all
-be zero so the sort will end up being an expensive no-op (expensive
-because, sadly, quicksort can be O(n^2) on presorted elements.)
+In the (common) case that we have no exported dates the order is already
+right, so we don't sort at all.
 */
 
-
-int DuplicateFilter::compare(const void* a, const void* b)
+bool DuplicateFilter::exported_later(const Waypoint* a, const Waypoint* b)
 {
-  const wpt_ptr* wa = (wpt_ptr*)a;
-  const wpt_ptr* wb = (wpt_ptr*)b;
-
-  if (wa->wpt->gc_data->exported < wb->wpt->gc_data->exported) {
-    return 1;
-  } else if (wa->wpt->gc_data->exported > wb->wpt->gc_data->exported) {
-    return -1;
-  }
-
-  /* If the exported dates are the same, sort by index. */
-  if (wa->index < wb->index) {
-    return -1;
-  } else if (wa->index > wb->index) {
-    return 1;
-  }
-
-  /* If index and date are the same, it's the same element. */
-  return 0;
-
+  return a->gc_data->exported > b->gc_data->exported;
 }
 
 void DuplicateFilter::process()
 {
-  Waypoint* waypointp;
-  btree_node* newnode, * btmp, * sup_tree = nullptr;
-  btree_node* oldnode = nullptr;
-  unsigned long crc = 0;
-  struct {
-    char shortname[32];
-    char lat[13];
-    char lon[13];
-  } dupe;
-  Waypoint* delwpt = nullptr;
-
-  int ct = waypt_count();
-
-  wpt_ptr* htable = (wpt_ptr*) xmalloc(ct * sizeof(*htable));
-  wpt_ptr* bh = htable;
-
-  int i = 0;
+  QVector<Waypoint*> htable;
+  htable.reserve(waypt_count());
   foreach (Waypoint* waypointp, *global_waypoint_list) {
-    bh->wpt = waypointp;
-    bh->index = i;
-    i ++;
-    bh ++;
+    htable.append(waypointp);
   }
-  qsort(htable, ct, sizeof(*htable), compare);
-
-  for (i=0; i<ct; i++) {
-    waypointp = htable[i].wpt;
 
-    memset(&dupe, '\0', sizeof(dupe));
-
-    if (snopt) {
-      strncpy(dupe.shortname, CSTRc(waypointp->shortname), sizeof(dupe.shortname) - 1);
+  bool all_same_date = true;
+  for (const Waypoint* waypointp : qAsConst(htable)) {
+    if (waypointp->gc_data->exported != htable.first()->gc_data->exported) {
+      all_same_date = false;
+      break;
     }
+  }
+  if (!all_same_date) {
+    std::stable_sort(htable.begin(), htable.end(), exported_later);
+  }
 
-    if (lcopt) {
-      /* let sprintf take care of rounding */
-      sprintf(dupe.lat, "%11.4f", waypointp->latitude);
-      sprintf(dupe.lon, "%11.4f", waypointp->longitude);
-      /* The degrees2ddmm stuff is a feeble attempt to
-       * get everything rounded the same way in a precision
-       * that's "close enough" for determining duplicates.
-       */
-      sprintf(dupe.lat, "%11.3f", degrees2ddmm(waypointp->latitude));
-      sprintf(dupe.lon, "%11.3f", degrees2ddmm(waypointp->longitude));
-
+  /*
+   * Map each key to the first point seen with it.  The value becomes
+   * nullptr once that point itself has been purged, but the key stays
+   * so later copies are still recognized as duplicates.
+   */
+  QHash<dupe_key, Waypoint*> sup_table;
+  sup_table.reserve(htable.size());
+
+  for (Waypoint* waypointp : qAsConst(htable)) {
+    const dupe_key key = make_key(waypointp);
+    auto it = sup_table.find(key);
+
+    if (it == sup_table.end()) {
+      sup_table.insert(key, waypointp);
+      continue;
     }
 
-    crc = get_crc32(&dupe, sizeof(dupe));
-
-    newnode = (btree_node*)xcalloc(sizeof(btree_node), 1);
-    newnode->data = crc;
-    newnode->wpt = waypointp;
-
-    btmp = addnode(sup_tree, newnode, &oldnode);
-
-    if (btmp == nullptr) {
-      delete delwpt;
-      if (correct_coords && oldnode && oldnode->wpt) {
-        oldnode->wpt->latitude = waypointp->latitude;
-        oldnode->wpt->longitude = waypointp->longitude;
-      }
-      delwpt = waypointp;
-      waypt_del(waypointp); /* collision */
-      xfree(newnode);
-      if (purge_duplicates && oldnode) {
-        if (oldnode->wpt) {
-          waypt_del(oldnode->wpt);
-          delete oldnode->wpt;
-          oldnode->wpt = nullptr;
-        }
-      }
-
-    } else {
-      sup_tree = btmp;
+    /* collision */
+    Waypoint* oldwpt = it.value();
+    if (correct_coords && oldwpt) {
+      oldwpt->latitude = waypointp->latitude;
+      oldwpt->longitude = waypointp->longitude;
+    }
+    waypointp->wpt_flags.marked_for_deletion = 1;
+    if (purge_duplicates && oldwpt) {
+      oldwpt->wpt_flags.marked_for_deletion = 1;
+      it.value() = nullptr;
     }
   }
 
-  delete delwpt;
-
-  xfree(htable);
-  if (sup_tree) {
-    free_tree(sup_tree);
-  }
+  waypt_del_marked();
 }
 
 #endif
@@ -22,6 +22,10 @@
 #ifndef DUPLICATE_H_INCLUDED_
 #define DUPLICATE_H_INCLUDED_
 
+#include <QtCore/QByteArray>  // for QByteArray
+#include <QtCore/QHash>       // for qHash
+#include <QtCore/QtGlobal>    // for qint64, uint
+
 #include "defs.h"    // for ARGTYPE_BOOL, ARG_NOMINMAX, Waypoint (ptr only)
 #include "filter.h"  // for Filter
 
@@ -62,21 +66,39 @@ private:
     ARG_TERMINATOR
   };
 
-  typedef struct btree_node {
-    struct btree_node* left, *right;
-    unsigned long data;
-    Waypoint* wpt;
-  } btree_node;
-
-  btree_node* addnode(btree_node* tree, btree_node* newnode, btree_node** oldnode);
-  void free_tree(btree_node* tree);
+  /*
+   * Everything that decides whether two points are duplicates: the name
+   * as the old fixed 31 character buffer held it, and the coordinates in
+   * ddmm.mmm as printf("%11.3f") would round them.  text is only used for
+   * coordinates coord_key() can't represent.
+   */
+  struct dupe_key {
+    QByteArray shortname;
+    QByteArray text;
+    qint64 lat{0};
+    qint64 lon{0};
+
+    friend bool operator==(const dupe_key& a, const dupe_key& b)
+    {
+      return (a.lat == b.lat) && (a.lon == b.lon) &&
+             (a.shortname == b.shortname) && (a.text == b.text);
+    }
 
-  typedef struct {
-    Waypoint* wpt;
-    int index;
-  } wpt_ptr;
+    friend uint qHash(const dupe_key& key, uint seed = 0)
+    {
+      uint h = qHash(key.lat, seed);
+      h = h * 31 + qHash(key.lon, seed);
+      h = h * 31 + qHash(key.shortname, seed);
+      if (!key.text.isEmpty()) {
+        h = h * 31 + qHash(key.text, seed);
+      }
+      return h;
+    }
+  };
 
-  static int compare(const void* a, const void* b);
+  static bool coord_key(double d, qint64* key);
+  dupe_key make_key(const Waypoint* waypointp) const;
+  static bool exported_later(const Waypoint* a, const Waypoint* b);
 
 };
 #endif
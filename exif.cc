@@ -37,23 +37,27 @@
 #include "defs.h"
 #include "garmin_tables.h"         // for gt_lookup_datum_index
 #include "gbfile.h"                // for gbfile, gbfclose, gbfcopyfrom, gbfseek, gbfwrite, gbfopen_be, gbftell, gbfputuint16, gbfputuint32, gbfgetuint16, gbfgetuint32, gbfread, gbfrewind, gbfgetflt
+#include "grtcirc.h"                // for linepart
 #include "jeeps/gpsmath.h"         // for GPS_Math_WGS84_To_Known_Datum_M
 #include "src/core/datetime.h"     // for DateTime
 #include <QtCore/QByteArray>       // for QByteArray
 #include <QtCore/QDate>            // for QDate
 #include <QtCore/QDateTime>        // for QDateTime
+#include <QtCore/QDir>             // for QDir, QDir::Files, QDir::Name
 #include <QtCore/QFile>            // for QFile
+#include <QtCore/QFileInfo>        // for QFileInfo
 #include <QtCore/QList>            // for QList<>::iterator, QList
 #include <QtCore/QPair>            // for QPair
 #include <QtCore/QRegExp>          // for QRegExp
 #include <QtCore/QString>          // for QString
+#include <QtCore/QStringList>      // for QStringList
 #include <QtCore/QTextCodec>       // for QTextCodec
 #include <QtCore/QTime>            // for QTime
 #include <QtCore/QVariant>         // for QVariant
 #include <QtCore/QVector>          // for QVector
 #include <QtCore/Qt>               // for UTC, ISODate
 #include <QtCore/QtGlobal>         // for qPrintable
-#include <algorithm>               // for sort, min
+#include <algorithm>               // for sort, min, lower_bound, stable_sort
 #include <cassert>                 // for assert
 #include <cctype>                  // for isprint, isspace
 #include <cfloat>                  // for DBL_EPSILON
@@ -189,17 +193,29 @@ static gbfile* fin, *fout;
 static QList<ExifApp>* exif_apps;
 static ExifApp* exif_app;
 static const Waypoint* exif_wpt_ref;
+static const Waypoint* exif_wpt_prev;
+static const Waypoint* exif_wpt_next;
+static Waypoint* exif_wpt_interp;
 static QDateTime exif_time_ref;
+static QString exif_batch_dir;
+
+struct ExifTimeRef {
+  qint64 msecs;
+  int seq;  /* order of discovery, for ties */
+  const Waypoint* wpt;
+};
+static QVector<ExifTimeRef> exif_time_index;
 static char exif_success;
 static QString exif_fout_name;
 
-static char* opt_filename, *opt_overwrite, *opt_frame, *opt_name;
+static char* opt_filename, *opt_overwrite, *opt_frame, *opt_name, *opt_interpolate;
 
 static uint8_t writer_gps_tag_version[4] = {2, 0, 0, 0};
 
 static arglist_t exif_args[] = {
   { "filename", &opt_filename, "Set waypoint name to source filename", "Y", ARGTYPE_BOOL, ARG_NOMINMAX, nullptr },
   { "frame", &opt_frame, "Time-frame (in seconds)", "10", ARGTYPE_INT, "0", nullptr, nullptr },
+  { "interpolate", &opt_interpolate, "Interpolate the position between the points before and after the picture", "N", ARGTYPE_BOOL, ARG_NOMINMAX, nullptr },
   { "name", &opt_name, "Locate waypoint for tagging by this name", nullptr, ARGTYPE_STRING, ARG_NOMINMAX, nullptr },
   { "overwrite", &opt_overwrite, "!OVERWRITE! the original file. Default=N", "N", ARGTYPE_BOOL, ARG_NOMINMAX, nullptr },
   ARG_TERMINATOR
@@ -1229,6 +1245,18 @@ exif_find_wpt_by_time(const Waypoint* wpt)
   } else if (labs(exif_time_ref.msecsTo(wpt->creation_time)) < labs(exif_time_ref.msecsTo(exif_wpt_ref->creation_time))) {
     exif_wpt_ref = wpt;
   }
+
+  /* The neighbours for interpolation, the first met on ties. */
+  const qint64 dt = exif_time_ref.msecsTo(wpt->creation_time);
+  if (dt < 0) {
+    if ((exif_wpt_prev == nullptr) || (exif_wpt_prev->creation_time < wpt->creation_time)) {
+      exif_wpt_prev = wpt;
+    }
+  } else if (dt > 0) {
+    if ((exif_wpt_next == nullptr) || (wpt->creation_time < exif_wpt_next->creation_time)) {
+      exif_wpt_next = wpt;
+    }
+  }
 }
 
 static void
@@ -1513,9 +1541,29 @@ exif_read()
   }
 }
 
-static void
-exif_wr_init(const QString& fname)
+/*
+ * Load the EXIF data of one image and open its output file.  In batch
+ * mode an image that can't be read or written, isn't a JPEG, or has no
+ * EXIF data or timestamp is skipped with a warning; for a single image
+ * that's fatal.
+ */
+static bool
+exif_open_image(const QString& fname)
 {
+  QString filename(fname);
+  filename += ".jpg";
+
+  if (!exif_batch_dir.isEmpty()) {
+    /* gbfopen would give up on the whole run */
+    QFileInfo in(fname);
+    QFileInfo out(filename);
+    bool writable = out.exists() ? out.isWritable() : QFileInfo(out.path()).isWritable();
+    if ((in.size() < 2) || !in.isReadable() || !writable) {
+      warning(MYNAME ": Cannot process picture \"%s\", skipped.\n", qPrintable(fname));
+      return false;
+    }
+  }
+
   exif_success = 0;
   exif_fout_name = fname;
 
@@ -1525,26 +1573,41 @@ exif_wr_init(const QString& fname)
   is_fatal(fin->is_pipe, MYNAME ": Sorry, this format cannot be used with pipes!");
 
   uint16_t soi = gbfgetuint16(fin);
+  if ((soi != 0xFFD8) && !exif_batch_dir.isEmpty()) {
+    warning(MYNAME ": Unknown image file \"%s\", skipped.\n", fin->name);
+    exif_release_apps();
+    gbfclose(fin);
+    return false;
+  }
   is_fatal(soi != 0xFFD8, MYNAME ": Unknown image file.");
   exif_app = exif_load_apps();
+  if (exif_app == nullptr && !exif_batch_dir.isEmpty()) {
+    warning(MYNAME ": No EXIF header found in source file \"%s\", skipped.\n", fin->name);
+    exif_release_apps();
+    gbfclose(fin);
+    return false;
+  }
   is_fatal(exif_app == nullptr, MYNAME ": No EXIF header found in source file \"%s\".", fin->name);
   exif_examine_app(exif_app);
   gbfclose(fin);
 
   exif_time_ref = exif_get_exif_time(exif_app);
   if (!exif_time_ref.isValid()) {
+    if (!exif_batch_dir.isEmpty()) {
+      warning(MYNAME ": No valid timestamp found in picture \"%s\", skipped.\n", qPrintable(fname));
+      exif_release_apps();
+      return false;
+    }
     fatal(MYNAME ": No valid timestamp found in picture!\n");
   }
 
-  QString filename(fname);
-  filename += ".jpg";
   fout = gbfopen_be(filename, "wb", MYNAME);
+  return true;
 }
 
 static void
-exif_wr_deinit()
+exif_close_image()
 {
-
   exif_release_apps();
   QString tmpname = QString(fout->name);
   gbfclose(fout);
@@ -1562,45 +1625,109 @@ exif_wr_deinit()
 }
 
 static void
-exif_write()
+exif_wr_init(const QString& fname)
+{
+  /* A directory means: tag every JPEG in it. */
+  exif_batch_dir.clear();
+  if (QFileInfo(fname).isDir()) {
+    exif_batch_dir = fname;
+    return;
+  }
+
+  exif_open_image(fname);
+}
+
+static void
+exif_wr_deinit()
+{
+  delete exif_wpt_interp;
+  exif_wpt_interp = nullptr;
+
+  if (!exif_batch_dir.isEmpty()) {
+    exif_batch_dir.clear();
+    exif_time_index.clear();
+    return;
+  }
+
+  exif_close_image();
+}
+
+static const Waypoint*
+exif_find_named_wpt()
 {
   exif_wpt_ref = nullptr;
 
-  if (opt_name) {
-    waypt_disp_all(exif_find_wpt_by_name);
-    if (exif_wpt_ref == nullptr) {
-      route_disp_all(nullptr, nullptr, exif_find_wpt_by_name);
-    }
-    if (exif_wpt_ref == nullptr) {
-      track_disp_all(nullptr, nullptr, exif_find_wpt_by_name);
-    }
-    if (exif_wpt_ref == nullptr) {
-      warning(MYNAME ": No matching point with name \"%s\" found.\n", opt_name);
-    }
-  } else {
-    track_disp_all(nullptr, nullptr, exif_find_wpt_by_time);
-    route_disp_all(nullptr, nullptr, exif_find_wpt_by_time);
-    waypt_disp_all(exif_find_wpt_by_time);
+  waypt_disp_all(exif_find_wpt_by_name);
+  if (exif_wpt_ref == nullptr) {
+    route_disp_all(nullptr, nullptr, exif_find_wpt_by_name);
+  }
+  if (exif_wpt_ref == nullptr) {
+    track_disp_all(nullptr, nullptr, exif_find_wpt_by_name);
+  }
+  if (exif_wpt_ref == nullptr) {
+    warning(MYNAME ": No matching point with name \"%s\" found.\n", opt_name);
+  }
+  return exif_wpt_ref;
+}
 
-    qint64 frame = atoi(opt_frame);
-
-    if (exif_wpt_ref == nullptr) {
-      warning(MYNAME ": No point with a valid timestamp found.\n");
-    } else if (labs(exif_time_ref.secsTo(exif_wpt_ref->creation_time)) > frame) {
-      QString str = exif_time_str(exif_time_ref);
-      warning(MYNAME ": No matching point found for image date %s!\n", qPrintable(str));
-      if (exif_wpt_ref != nullptr) {
-        QString str = exif_time_str(exif_wpt_ref->creation_time);
-        warning(MYNAME ": Best is from %s, %ld second(s) away.\n",
-                qPrintable(str), labs(exif_time_ref.secsTo(exif_wpt_ref->creation_time)));
-      }
-      exif_wpt_ref = nullptr;
-    }
+/*
+ * Reject the point closest in time to the picture if it is more than
+ * the time-frame away.
+ */
+static const Waypoint*
+exif_check_frame(const Waypoint* wpt)
+{
+  qint64 frame = atoi(opt_frame);
+
+  if (wpt == nullptr) {
+    warning(MYNAME ": No point with a valid timestamp found.\n");
+  } else if (labs(exif_time_ref.secsTo(wpt->creation_time)) > frame) {
+    QString str = exif_time_str(exif_time_ref);
+    warning(MYNAME ": No matching point found for image date %s!\n", qPrintable(str));
+    str = exif_time_str(wpt->creation_time);
+    warning(MYNAME ": Best is from %s, %ld second(s) away.\n",
+            qPrintable(str), labs(exif_time_ref.secsTo(wpt->creation_time)));
+    wpt = nullptr;
   }
+  return wpt;
+}
 
-  if (exif_wpt_ref != nullptr) {
-    const Waypoint* wpt = exif_wpt_ref;
+/*
+ * With the interpolate option a picture taken between two points is
+ * placed on the great circle between them, in proportion to its time.
+ * Everything else comes from the nearest point, which has to be within
+ * the time-frame as before.
+ */
+static const Waypoint*
+exif_interpolate(const Waypoint* wpt, const Waypoint* prev, const Waypoint* next)
+{
+  if ((*opt_interpolate != '1') || (wpt == nullptr) || (prev == nullptr) || (next == nullptr) ||
+      (exif_time_ref.msecsTo(wpt->creation_time) == 0)) {
+    return wpt;
+  }
+
+  double frac = (double)prev->creation_time.msecsTo(exif_time_ref) /
+                (double)prev->creation_time.msecsTo(next->creation_time);
+  delete exif_wpt_interp;
+  exif_wpt_interp = new Waypoint(*wpt);
+  linepart(prev->latitude, prev->longitude,
+           next->latitude, next->longitude,
+           frac,
+           &exif_wpt_interp->latitude,
+           &exif_wpt_interp->longitude);
+  if ((prev->altitude != unknown_alt) && (next->altitude != unknown_alt)) {
+    exif_wpt_interp->altitude = prev->altitude + frac * (next->altitude - prev->altitude);
+  } else {
+    exif_wpt_interp->altitude = unknown_alt;
+  }
+  exif_wpt_interp->SetCreationTime(exif_time_ref);
+  return exif_wpt_interp;
+}
 
+static void
+exif_tag_image(const Waypoint* wpt)
+{
+  if (wpt != nullptr) {
     exif_put_long(IFD0, IFD0_TAG_GPS_IFD_OFFS, 0, 0);
     exif_put_value(GPS_IFD, GPS_IFD_TAG_VERSION, EXIF_TYPE_BYTE, 4, 0, writer_gps_tag_version);
     exif_put_str(GPS_IFD, GPS_IFD_TAG_DATUM, "WGS-84");
@@ -1666,7 +1793,130 @@ exif_write()
 
     exif_success = 1;
   }
+}
+
+static void
+exif_index_wpt_by_time(const Waypoint* wpt)
+{
+  if (wpt->creation_time.isValid()) {
+    exif_time_index.append({wpt->creation_time.toMSecsSinceEpoch(), exif_time_index.size(), wpt});
+  }
+}
+
+static bool
+exif_time_index_before(const ExifTimeRef& a, const ExifTimeRef& b)
+{
+  return a.msecs < b.msecs;
+}
+
+/*
+ * Binary search version of the exif_find_wpt_by_time() scan over the
+ * index built by exif_write_batch().  Within a run of equal times the
+ * first entry is the one the scan would have met first; between the
+ * neighbours before and after the picture time the nearer one wins,
+ * and on a tie again the one the scan would have met first.  The
+ * neighbours strictly before and after are left in exif_wpt_prev and
+ * exif_wpt_next, as the scan leaves them.
+ */
+static const Waypoint*
+exif_lookup_wpt_by_time()
+{
+  exif_wpt_prev = exif_wpt_next = nullptr;
+  if (exif_time_index.isEmpty()) {
+    return nullptr;
+  }
+
+  const ExifTimeRef key{exif_time_ref.toMSecsSinceEpoch(), 0, nullptr};
+  const auto first = exif_time_index.cbegin();
+  const auto last = exif_time_index.cend();
+  const auto after = std::lower_bound(first, last, key, exif_time_index_before);
+
+  const ExifTimeRef* best = nullptr;
+  if (after != last) {
+    best = &*after;
+    if (after->msecs > key.msecs) {
+      exif_wpt_next = after->wpt;
+    }
+  }
+  if (after != first) {
+    const ExifTimeRef probe{(after - 1)->msecs, 0, nullptr};
+    const ExifTimeRef* before = &*std::lower_bound(first, after, probe, exif_time_index_before);
+    exif_wpt_prev = before->wpt;
+    if (best == nullptr) {
+      best = before;
+    } else {
+      const qint64 dbefore = key.msecs - before->msecs;
+      const qint64 dafter = best->msecs - key.msecs;
+      if ((dbefore < dafter) || ((dbefore == dafter) && (before->seq < best->seq))) {
+        best = before;
+      }
+    }
+  }
+  return best->wpt;
+}
+
+/*
+ * Tag every JPEG in exif_batch_dir.  The points are collected and sorted
+ * by time once, so each picture costs a binary search instead of a walk
+ * over all the data.
+ */
+static void
+exif_write_batch()
+{
+  const Waypoint* named = nullptr;
 
+  if (opt_name) {
+    named = exif_find_named_wpt();
+  } else {
+    exif_time_index.clear();
+    /* Same order as the single image scan, which matters for ties. */
+    track_disp_all(nullptr, nullptr, exif_index_wpt_by_time);
+    route_disp_all(nullptr, nullptr, exif_index_wpt_by_time);
+    waypt_disp_all(exif_index_wpt_by_time);
+    std::stable_sort(exif_time_index.begin(), exif_time_index.end(), exif_time_index_before);
+  }
+
+  QDir dir(exif_batch_dir);
+  const QStringList images = dir.entryList(QStringList() << "*.jpg" << "*.jpeg",
+                             QDir::Files, QDir::Name);
+  for (const auto& image : images) {
+    /* Without overwrite an earlier run left "name.jpg" next to its
+       source "name", don't tag that again. */
+    if (image.endsWith(".jpg", Qt::CaseInsensitive) &&
+        images.contains(image.left(image.size() - 4), Qt::CaseInsensitive)) {
+      continue;
+    }
+    if (!exif_open_image(dir.filePath(image))) {
+      continue;
+    }
+    if (opt_name) {
+      exif_tag_image(named);
+    } else {
+      const Waypoint* wpt = exif_check_frame(exif_lookup_wpt_by_time());
+      exif_tag_image(exif_interpolate(wpt, exif_wpt_prev, exif_wpt_next));
+    }
+    exif_close_image();
+  }
+}
+
+static void
+exif_write()
+{
+  if (!exif_batch_dir.isEmpty()) {
+    exif_write_batch();
+    return;
+  }
+
+  if (opt_name) {
+    exif_tag_image(exif_find_named_wpt());
+  } else {
+    exif_wpt_ref = exif_wpt_prev = exif_wpt_next = nullptr;
+    track_disp_all(nullptr, nullptr, exif_find_wpt_by_time);
+    route_disp_all(nullptr, nullptr, exif_find_wpt_by_time);
+    waypt_disp_all(exif_find_wpt_by_time);
+
+    exif_tag_image(exif_interpolate(exif_check_frame(exif_wpt_ref), exif_wpt_prev, exif_wpt_next));
+  }
 }
 
 /**************************************************************************/
@@ -68,6 +68,45 @@ public:
      * needed after the filter terminates. */
   }
 
+  /*
+   * Streaming conversion of tracks.
+   *
+   * A filter that only looks at one trackpoint at a time, or at a point
+   * and its predecessors in the same track, may take the trackpoints as
+   * the input is read, before the whole track has been read.  Tracks are
+   * then offered in order with stream_track() and their points with
+   * stream_point(); both are called after init().  Points pass through
+   * the filters in the order the filters were given, and on to the writer;
+   * then they are deleted.
+   * Waypoints and routes are left in the lists as usual, stream_finish()
+   * takes care of them after the input has been read.
+   */
+  virtual bool stream_capable()
+  {
+    /* Can the options in effect be streamed?  Called before init(). */
+    return false;
+  }
+
+  virtual bool stream_track(const route_head*)
+  {
+    /* Return false to drop the track from the stream.  Its points are
+     * still offered to this filter, but not to those after it. */
+    return true;
+  }
+
+  virtual bool stream_point(Waypoint*)
+  {
+    /* Return false to drop the point.  Points that should be added in
+     * front of this one are handed on with track_stream_insert(). */
+    return true;
+  }
+
+  virtual void stream_finish()
+  {
+    /* Called instead of process() when the input has been read. */
+    process();
+  }
+
   virtual void exit()
   {
     /* called on program exit */
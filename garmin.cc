@@ -460,7 +460,7 @@ static unsigned int checkWayPointIsAtSplit(Waypoint* wpt, GPS_PLap* laps, int nl
   if ((laps != nullptr) && (nlaps > 0)) {
     for (int i = (nlaps-1); i >= 0; i--) {
       GPS_PLap lap = laps[i];
-      time_t delta = lap->start_time - wpt->GetCreationTime().toTime_t();
+      time_t delta = lap->start_time - wpt->creation_time.toTime_t();
       if ((delta >= -1) && (delta <= 1)) {
         result = 1;
         break;
@@ -1151,7 +1151,7 @@ track_waypt_pr(const Waypoint* wpt)
   (*cur_tx_tracklist_entry)->lat = wpt->latitude;
   (*cur_tx_tracklist_entry)->lon = wpt->longitude;
   (*cur_tx_tracklist_entry)->alt = (wpt->altitude != unknown_alt) ? wpt->altitude : 1e25;
-  (*cur_tx_tracklist_entry)->Time = wpt->GetCreationTime().toTime_t();
+  (*cur_tx_tracklist_entry)->Time = wpt->creation_time.toTime_t();
   if (!wpt->shortname.isEmpty()) {
     strncpy((*cur_tx_tracklist_entry)->trk_ident, CSTRc(wpt->shortname), sizeof((*cur_tx_tracklist_entry)->trk_ident));
     (*cur_tx_tracklist_entry)->trk_ident[sizeof((*cur_tx_tracklist_entry)->trk_ident)-1] = 0;
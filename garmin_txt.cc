@@ -259,11 +259,11 @@ prework_wpt_cb(const Waypoint* wpt)
   const Waypoint* prev = cur_info->prev_wpt;
 
   if (prev != nullptr) {
-    cur_info->time += (wpt->GetCreationTime().toTime_t() - prev->GetCreationTime().toTime_t());
+    cur_info->time += (wpt->creation_time.toTime_t() - prev->creation_time.toTime_t());
     cur_info->length += waypt_distance_ex(prev, wpt);
   } else {
     cur_info->first_wpt = wpt;
-    cur_info->start = wpt->GetCreationTime().toTime_t();
+    cur_info->start = wpt->creation_time.toTime_t();
   }
   cur_info->prev_wpt = wpt;
   cur_info->count++;
@@ -599,7 +599,7 @@ write_waypt(const Waypoint* wpt)
   print_string("%s\t", GMSD_GET(state, ""));
   const char* country = gt_get_icao_country(GMSD_GET(cc, ""));
   print_string("%s\t", (country != nullptr) ? country : "");
-  print_date_and_time(wpt->GetCreationTime().toTime_t(), 0);
+  print_date_and_time(wpt->creation_time.toTime_t(), 0);
   if (wpt->HasUrlLink()) {
     UrlLink l = wpt->GetUrlLink();
     print_string("%s\t", l.url_);
@@ -709,7 +709,7 @@ track_disp_wpt_cb(const Waypoint* wpt)
   gbfprintf(fout, "Trackpoint\t");
 
   print_position(wpt);
-  print_date_and_time(wpt->GetCreationTime().toTime_t(), 0);
+  print_date_and_time(wpt->creation_time.toTime_t(), 0);
   if IS_VALID_ALT(wpt->altitude) {
     print_distance(wpt->altitude, 1, 0, 0);
   }
@@ -722,7 +722,7 @@ track_disp_wpt_cb(const Waypoint* wpt)
 
   if (prev != nullptr) {
     gbfprintf(fout, "\t");
-    delta = wpt->GetCreationTime().toTime_t() - prev->GetCreationTime().toTime_t();
+    delta = wpt->creation_time.toTime_t() - prev->creation_time.toTime_t();
     float temp = WAYPT_GET(wpt, temperature, -999);
     if (temp != -999) {
       print_temperature(temp);
@@ -21,13 +21,15 @@
  */
 
 #include <QtCore/QByteArray>   // for QByteArray
+#include <QtCore/QFile>        // for QFile
+#include <QtCore/QFileDevice>  // for QFileDevice::MapPrivateOption
 #include <QtCore/QString>      // for QString
 #include <QtCore/QtGlobal>     // for qPrintable
 
 #include <cassert>             // for assert
 #include <cstdarg>             // for va_list, va_end, va_copy, va_start
 #include <cstdio>              // for EOF, ferror, ftell, SEEK_SET, SEEK_CUR, SEEK_END, clearerr, fclose, feof, fflush, fileno, fread, fseek, fwrite, ungetc, vsnprintf, FILE, stdin, stdout
-#include <cstring>             // for memcpy, strlen, strchr, strcpy, strncat
+#include <cstring>             // for memcpy, memchr, memmove, strlen, strchr, strcpy, strncat
 #include <ctype.h>             // for tolower
 #include <errno.h>             // for errno
 
@@ -493,6 +495,229 @@ memapi_error(gbfile* self)
 }
 
 
+/*******************************************************************************/
+/* %%%                   Memory mapped input file (mapapi)                  %%% */
+/*******************************************************************************/
+
+/*
+ * Plain (not gzipped) regular files opened for reading are mapped into
+ * memory and then read like a memory stream.  The mapping is private,
+ * so gbfungetc can still write into it.  Read, seek and eof behave like
+ * the zlib api that would otherwise handle these files.
+ */
+
+static int
+mapapi_map(gbfile* self)
+{
+  auto* file = new QFile(QString::fromUtf8(self->name));
+  qint64 size = 0;
+  uchar* mem = nullptr;
+
+  if (file->open(QIODevice::ReadOnly)) {
+    size = file->size();
+    /* gbsize_t positions can't go further */
+    if ((size > 0) && (size < 0xFFFFFFFF)) {
+      mem = file->map(0, size, QFileDevice::MapPrivateOption);
+    }
+  }
+  /* leave gzipped data to zlib */
+  if ((mem == nullptr) || ((size >= 2) && (mem[0] == 0x1f) && (mem[1] == 0x8b))) {
+    delete file;
+    return 0;
+  }
+
+  self->mapfile = file;
+  self->handle.mem = mem;
+  self->mempos = 0;
+  self->memlen = self->memsz = size;
+  return 1;
+}
+
+static gbfile*
+mapapi_open(gbfile* self, const char* mode)
+{
+  (void)mode;
+  /* already mapped by mapapi_map */
+  return self;
+}
+
+static int
+mapapi_close(gbfile* self)
+{
+  delete self->mapfile;  /* unmaps */
+  self->mapfile = nullptr;
+  self->handle.mem = nullptr;
+  return 0;
+}
+
+static int
+mapapi_seek(gbfile* self, int32_t offset, int whence)
+{
+  long long pos = self->mempos;
+
+  switch (whence) {
+  case SEEK_CUR:
+    pos += offset;
+    break;
+  case SEEK_END:
+    pos = (long long) self->memlen + offset;
+    break;
+  case SEEK_SET:
+    pos = offset;
+    break;
+  }
+
+  if (pos < 0) {
+    fatal("%s: Unable to set file (%s) to position (%lld)!\n",
+          self->module, self->name, pos);
+  }
+  if (pos > self->memlen) {
+    pos = self->memlen;
+  }
+  self->mempos = pos;
+  return 0;
+}
+
+static gbsize_t
+mapapi_read(void* buf, const gbsize_t size, const gbsize_t members, gbfile* self)
+{
+  gbsize_t count = size * members;
+  if (count > self->memlen - self->mempos) {
+    count = self->memlen - self->mempos;
+  }
+  memcpy(buf, self->handle.mem + self->mempos, count);
+  self->mempos += count;
+
+  /* Check for an incomplete READ */
+  if ((members == 1) && (size > 1) && (count > 0) && (count < size)) {
+    fatal("%s: Unexpected end of file (EOF)!\n", self->module);
+  }
+
+  return count / size;
+}
+
+static gbsize_t
+mapapi_write(const void* buf, const gbsize_t size, const gbsize_t members, gbfile* self)
+{
+  (void)buf;
+  (void)size;
+  (void)members;
+  (void)self;
+  return 0;  /* opened for reading only */
+}
+
+/*
+ * gbf_mapped: direct access to the next len bytes of a mapped file, or
+ *             nullptr if the caller has to go the regular way.
+ */
+
+static inline const unsigned char*
+gbf_mapped(gbfile* file, const gbsize_t len)
+{
+  if (file->mapapi && (file->rbuf == nullptr) &&
+      (file->memlen - file->mempos >= len)) {
+    const unsigned char* p = file->handle.mem + file->mempos;
+    file->mempos += len;
+    return p;
+  }
+  return nullptr;
+}
+
+
+/*******************************************************************************/
+/* %%%                        Read-ahead buffer                            %%% */
+/*******************************************************************************/
+
+/*
+ * gbfgetstr reads plain and gzipped input files through a large buffer
+ * instead of one gbfgetc per byte.  Once the buffer exists, gbfgetc,
+ * gbfread, gbfungetc, gbfseek, gbftell and gbfeof all consult it first,
+ * so line and binary reads can still be mixed freely.  Data starts at
+ * rbuf[1], which keeps room for a gbfungetc right after a refill.
+ */
+
+#define GBF_READAHEAD 65536
+
+static int
+gbf_readahead_ok(const gbfile* file)
+{
+  /* pipes are left alone so that line by line input isn't held back,
+     mapped files are read in place by gbfgetstr_mapped */
+  return (file->mode == 'r') && !file->memapi && !file->mapapi && !file->is_pipe;
+}
+
+/*
+ * gbf_refill: move the unconsumed bytes to the front of the buffer and
+ *             top it up from the file; returns the number of new bytes.
+ */
+
+static gbsize_t
+gbf_refill(gbfile* file)
+{
+  if (file->rbuf == nullptr) {
+    file->rbufsz = GBF_READAHEAD;
+    file->rbuf = (unsigned char*) xmalloc(file->rbufsz);
+    file->rbufpos = file->rbuflen = 1;
+  }
+
+  gbsize_t keep = file->rbuflen - file->rbufpos;
+  if (keep > 0 && file->rbufpos != 1) {
+    memmove(file->rbuf + 1, file->rbuf + file->rbufpos, keep);
+  }
+  file->rbufpos = 1;
+  file->rbuflen = 1 + keep;
+
+  if (file->rbuflen == file->rbufsz) {
+    file->rbufsz *= 2;
+    file->rbuf = (unsigned char*) xrealloc(file->rbuf, file->rbufsz);
+  }
+
+  gbsize_t n = file->fileread(file->rbuf + file->rbuflen, 1,
+                              file->rbufsz - file->rbuflen, file);
+  file->rbuflen += n;
+  return n;
+}
+
+static gbsize_t
+gbf_buffered_read(void* buf, const gbsize_t size, const gbsize_t members, gbfile* file)
+{
+  char* target = (char*) buf;
+  gbsize_t count = size * members;
+  gbsize_t got = 0;
+
+  while (got < count) {
+    gbsize_t avail = file->rbuflen - file->rbufpos;
+    if (avail == 0) {
+      if (count - got >= file->rbufsz) {
+        /* big block, don't bother staging it */
+        got += file->fileread(target + got, 1, count - got, file);
+        if (got < count) {
+          file->rbuf_eof = 1;
+        }
+        break;
+      }
+      if (gbf_refill(file) == 0) {
+        file->rbuf_eof = 1;
+        break;
+      }
+      continue;
+    }
+    if (avail > count - got) {
+      avail = count - got;
+    }
+    memcpy(target + got, file->rbuf + file->rbufpos, avail);
+    file->rbufpos += avail;
+    got += avail;
+  }
+
+  /* Same check as gzapi_read for an incomplete READ */
+  if ((file->gzapi || file->mapapi) && (members == 1) && (size > 1) && (got > 0) && (got < size)) {
+    fatal("%s: Unexpected end of file (EOF)!\n", file->module);
+  }
+
+  return got / size;
+}
+
 /* GPSBabel 'file' standard calls */
 
 /*
@@ -554,7 +779,22 @@ gbfopen(const QString& filename, const char* mode, const char* module)
 #endif
     }
 
-    if (file->gzapi) {
+    if (file->gzapi && (file->mode == 'r') && !file->is_pipe && mapapi_map(file)) {
+      file->gzapi = 0;
+      file->mapapi = 1;
+
+      file->fileclearerr = memapi_clearerr;
+      file->fileclose = mapapi_close;
+      file->fileeof = memapi_eof;
+      file->fileerror = memapi_error;
+      file->fileflush = memapi_flush;
+      file->fileopen = mapapi_open;
+      file->fileread = mapapi_read;
+      file->fileseek = mapapi_seek;
+      file->filetell = memapi_tell;
+      file->fileungetc = memapi_ungetc;
+      file->filewrite = mapapi_write;
+    } else if (file->gzapi) {
 #if !ZLIB_INHIBITED
 
       file->fileclearerr = gzapi_clearerr;
@@ -621,6 +861,9 @@ gbfclose(gbfile* file)
 
   file->fileclose(file);
 
+  if (file->rbuf) {
+    xfree(file->rbuf);
+  }
   xfree(file->name);
   xfree(file->module);
   xfree(file->buff);
@@ -636,6 +879,21 @@ gbfgetc(gbfile* file)
 {
   unsigned char c;
 
+  if (file->mapapi && (file->rbuf == nullptr)) {
+    if (file->mempos == file->memlen) {
+      return EOF;
+    }
+    return file->handle.mem[file->mempos++];
+  }
+
+  if (file->rbuf != nullptr) {
+    if ((file->rbufpos == file->rbuflen) && (gbf_refill(file) == 0)) {
+      file->rbuf_eof = 1;
+      return EOF;
+    }
+    return file->rbuf[file->rbufpos++];
+  }
+
   /* errors are caught in gbfread */
   if (gbfread(&c, 1, 1, file) == 0) {
     return EOF;
@@ -690,6 +948,9 @@ gbfread(void* buf, const gbsize_t size, const gbsize_t members, gbfile* file)
   if ((size == 0) || (members == 0)) {
     return 0;
   }
+  if (file->rbuf != nullptr) {
+    return gbf_buffered_read(buf, size, members, file);
+  }
   return file->fileread(buf, size, members, file);
 }
 
@@ -828,6 +1089,7 @@ gbfflush(gbfile* file)
 void
 gbfclearerr(gbfile* file)
 {
+  file->rbuf_eof = 0;
   file->fileclearerr(file);
 }
 
@@ -859,6 +1121,14 @@ gbfrewind(gbfile* file)
 int
 gbfseek(gbfile* file, int32_t offset, int whence)
 {
+  if (file->rbuf != nullptr) {
+    /* the file is ahead of us by whatever is still buffered */
+    if (whence == SEEK_CUR) {
+      offset -= (int32_t)(file->rbuflen - file->rbufpos);
+    }
+    file->rbufpos = file->rbuflen = 1;
+    file->rbuf_eof = 0;
+  }
   return file->fileseek(file, offset, whence);
 }
 
@@ -873,6 +1143,9 @@ gbftell(gbfile* file)
   if ((signed) result == -1)
     fatal("%s: Could not determine position of file '%s'!\n",
           file->module, file->name);
+  if (file->rbuf != nullptr) {
+    result -= file->rbuflen - file->rbufpos;
+  }
   return result;
 }
 
@@ -883,6 +1156,15 @@ gbftell(gbfile* file)
 int
 gbfeof(gbfile* file)
 {
+  if (file->rbuf != nullptr) {
+    if (file->rbufpos < file->rbuflen) {
+      return 0;
+    }
+    /* stdio only reports EOF once a read has run into it */
+    if (!file->gzapi && !file->mapapi) {
+      return file->rbuf_eof;
+    }
+  }
   return file->fileeof(file);
 }
 
@@ -893,6 +1175,14 @@ gbfeof(gbfile* file)
 int
 gbfungetc(const int c, gbfile* file)
 {
+  if (file->rbuf != nullptr) {
+    if (file->rbufpos == 0) {
+      fatal(MYNAME ": Cannot store more than one byte back!\n");
+    }
+    file->rbuf[--file->rbufpos] = (unsigned char) c;
+    file->rbuf_eof = 0;
+    return c;
+  }
   return file->fileungetc(c, file);
 }
 
@@ -906,14 +1196,18 @@ int32_t
 gbfgetint32(gbfile* file)
 {
   char buf[4];
+  const void* p = gbf_mapped(file, sizeof(buf));
 
-  is_fatal((gbfread(&buf, 1, sizeof(buf), file) != sizeof(buf)),
-           "%s: Unexpected end of file (%s)!\n", file->module, file->name);
+  if (p == nullptr) {
+    is_fatal((gbfread(&buf, 1, sizeof(buf), file) != sizeof(buf)),
+             "%s: Unexpected end of file (%s)!\n", file->module, file->name);
+    p = buf;
+  }
 
   if (file->big_endian) {
-    return be_read32(buf);
+    return be_read32(p);
   } else {
-    return le_read32(buf);
+    return le_read32(p);
   }
 }
 
@@ -925,14 +1219,18 @@ int16_t
 gbfgetint16(gbfile* file)
 {
   char buf[2];
+  const void* p = gbf_mapped(file, sizeof(buf));
 
-  is_fatal((gbfread(&buf, 1, sizeof(buf), file) != sizeof(buf)),
-           "%s: Unexpected end of file (%s)!\n", file->module, file->name);
+  if (p == nullptr) {
+    is_fatal((gbfread(&buf, 1, sizeof(buf), file) != sizeof(buf)),
+             "%s: Unexpected end of file (%s)!\n", file->module, file->name);
+    p = buf;
+  }
 
   if (file->big_endian) {
-    return be_read16(buf);
+    return be_read16(p);
   } else {
-    return le_read16(buf);
+    return le_read16(p);
   }
 }
 
@@ -944,11 +1242,15 @@ double
 gbfgetdbl(gbfile* file)
 {
   char buf[8];
+  const void* p = gbf_mapped(file, sizeof(buf));
 
-  is_fatal((gbfread(&buf, 1, sizeof(buf), file) != sizeof(buf)),
-           "%s: Unexpected end of file (%s)!\n", file->module, file->name);
+  if (p == nullptr) {
+    is_fatal((gbfread(&buf, 1, sizeof(buf), file) != sizeof(buf)),
+             "%s: Unexpected end of file (%s)!\n", file->module, file->name);
+    p = buf;
+  }
 
-  return endian_read_double(buf, ! file->big_endian);
+  return endian_read_double(p, ! file->big_endian);
 }
 
 /*
@@ -959,11 +1261,15 @@ float
 gbfgetflt(gbfile* file)
 {
   char buf[4];
+  const void* p = gbf_mapped(file, sizeof(buf));
 
-  is_fatal((gbfread(&buf, 1, sizeof(buf), file) != sizeof(buf)),
-           "%s: Unexpected end of file (%s)!\n", file->module, file->name);
+  if (p == nullptr) {
+    is_fatal((gbfread(&buf, 1, sizeof(buf), file) != sizeof(buf)),
+             "%s: Unexpected end of file (%s)!\n", file->module, file->name);
+    p = buf;
+  }
 
-  return endian_read_float(buf, ! file->big_endian);
+  return endian_read_float(p, ! file->big_endian);
 }
 
 /*
@@ -977,6 +1283,19 @@ gbfgetcstr_old(gbfile* file)
   int len = 0;
   char* str = file->buff;
 
+  if (file->mapapi && (file->rbuf == nullptr)) {
+    const unsigned char* start = file->handle.mem + file->mempos;
+    gbsize_t avail = file->memlen - file->mempos;
+    const void* nul = memchr(start, 0, avail);
+    gbsize_t n = nul ? (const unsigned char*) nul - start : avail;
+
+    char* result = (char*) xmalloc(n + 1);
+    memcpy(result, start, n);
+    result[n] = '\0';
+    file->mempos += nul ? n + 1 : n;
+    return result;
+  }
+
   for (;;) {
     int c = gbfgetc(file);
 
@@ -1101,6 +1420,131 @@ gbfgetucs2str(gbfile* file)
   return result;
 }
 
+/*
+ * gbf_eol: length of the line at p, i.e. the offset of the first '\n',
+ *          '\r' or ^Z, or n if there is none.
+ */
+
+static gbsize_t
+gbf_eol(const unsigned char* p, gbsize_t n)
+{
+  const void* hit = memchr(p, '\n', n);
+  if (hit) {
+    n = (const unsigned char*) hit - p;
+  }
+  if ((hit = memchr(p, '\r', n))) {
+    n = (const unsigned char*) hit - p;
+  }
+  if ((hit = memchr(p, 0x1A, n))) {
+    n = (const unsigned char*) hit - p;
+  }
+  return n;
+}
+
+/*
+ * gbf_line: copy a line of len bytes into file->buff and terminate it, so
+ *           that it stays put whatever is read or put back next.
+ */
+
+static char*
+gbf_line(gbfile* file, const unsigned char* src, gbsize_t len)
+{
+  if ((gbsize_t) file->buffsz < len + 1) {
+    file->buffsz = len + 1;
+    file->buff = (char*) xrealloc(file->buff, file->buffsz);
+  }
+  memcpy(file->buff, src, len);
+  file->buff[len] = '\0';
+  return file->buff;
+}
+
+/*
+ * gbfgetstr_buffered: gbfgetstr for files with a read-ahead buffer.
+ */
+
+static char*
+gbfgetstr_buffered(gbfile* file)
+{
+  if (file->rbuf == nullptr) {
+    (void) gbf_refill(file);
+  }
+
+  gbsize_t scan = file->rbufpos;
+  for (;;) {
+    if (scan == file->rbuflen) {
+      gbsize_t done = scan - file->rbufpos;
+      if (gbf_refill(file) == 0) {
+        file->rbuf_eof = 1;
+        if (done == 0) {
+          return nullptr;
+        }
+        char* result = gbf_line(file, file->rbuf + file->rbufpos, done);
+        file->rbufpos = file->rbuflen;
+        return result;
+      }
+      scan = file->rbufpos + done;
+    }
+
+    scan += gbf_eol(file->rbuf + scan, file->rbuflen - scan);
+    if (scan < file->rbuflen) {
+      break;
+    }
+  }
+
+  const unsigned char term = file->rbuf[scan];
+  gbsize_t len = scan - file->rbufpos;
+  char* result = gbf_line(file, file->rbuf + file->rbufpos, len);
+  file->rbufpos = scan + 1;
+
+  if (term == 0x1A) {
+    return (len == 0) ? nullptr : result;
+  }
+  if (term == '\r') {
+    if ((file->rbufpos == file->rbuflen) && (gbf_refill(file) == 0)) {
+      file->rbuf_eof = 1;
+    }
+    if ((file->rbufpos < file->rbuflen) && (file->rbuf[file->rbufpos] == '\n')) {
+      file->rbufpos++;
+    }
+  }
+  return result;
+}
+
+/*
+ * gbfgetstr_mapped: gbfgetstr for memory mapped files, the lines are
+ *                   found right in the mapping.
+ */
+
+static char*
+gbfgetstr_mapped(gbfile* file)
+{
+  const unsigned char* p = file->handle.mem + file->mempos;
+  gbsize_t avail = file->memlen - file->mempos;
+
+  if (avail == 0) {
+    return nullptr;
+  }
+
+  gbsize_t len = gbf_eol(p, avail);
+  char* result = gbf_line(file, p, len);
+  file->mempos += len;
+  if (len == avail) {
+    return result;
+  }
+
+  const unsigned char term = p[len];
+  file->mempos++;
+
+  if (term == 0x1A) {
+    return (len == 0) ? nullptr : result;
+  }
+  if ((term == '\r') && (file->mempos < file->memlen) &&
+      (file->handle.mem[file->mempos] == '\n')) {
+    file->mempos++;
+  }
+  return result;
+}
+
 /*
  * gbfgetstr: Reads a string from file (util any type of line-breaks or eof or error)
  *            except xfree and free you can do all possible things with the result
@@ -1116,6 +1560,16 @@ gbfgetstr(gbfile* file)
     return gbfgetucs2str(file);
   }
 
+  /* once the byte order mark check is done, go the fast way */
+  if (file->unicode_checked) {
+    if (file->mapapi && (file->rbuf == nullptr)) {
+      return gbfgetstr_mapped(file);
+    }
+    if (gbf_readahead_ok(file)) {
+      return gbfgetstr_buffered(file);
+    }
+  }
+
   for (;;) {
     int c = gbfgetc(file);
 
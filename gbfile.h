@@ -32,6 +32,7 @@
 
 #include "defs.h"
 
+class QFile;
 
 struct gbfile_s;
 typedef struct gbfile_s gbfile;
@@ -66,13 +67,20 @@ typedef struct gbfile_s {
   gbsize_t mempos;	/* curr. position in memory */
   gbsize_t memlen;	/* max. number of written bytes to memory */
   gbsize_t memsz;		/* curr. size of allocated memory */
+  QFile* mapfile;	/* file behind a memory mapped handle.mem */
+  unsigned char* rbuf;	/* read-ahead buffer, set up by gbfgetstr */
+  gbsize_t rbufsz;	/* usable size of rbuf */
+  gbsize_t rbufpos;	/* next unconsumed byte in rbuf */
+  gbsize_t rbuflen;	/* end of valid data in rbuf */
   unsigned char big_endian:1;
   unsigned char binary:1;
   unsigned char gzapi:1;
   unsigned char memapi:1;
+  unsigned char mapapi:1;
   unsigned char unicode:1;
   unsigned char unicode_checked:1;
   unsigned char is_pipe:1;
+  unsigned char rbuf_eof:1;	/* a read from rbuf came up short */
   gbfclearerr_cb fileclearerr;
   gbfclose_cb fileclose;
   gbfeof_cb fileeof;
@@ -219,7 +219,7 @@ ggv_log_track_head_cb(const route_head* trk)
     double lonsec = 60.0 * (lonmin - floor(lonmin));
 
     if (wpt->creation_time.isValid()) {
-      time_t t = wpt->GetCreationTime().toTime_t();
+      time_t t = wpt->creation_time.toTime_t();
       tm = *gmtime(&t);
       tm.tm_mon += 1;
       tm.tm_year += 1900;
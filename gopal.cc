@@ -234,7 +234,7 @@ gopal_read()
         wpt->SetCreationTime(tx+((((time_t)tm.tm_hour * 60) + tm.tm_min) * 60) + tm.tm_sec);
         wpt->creation_time = wpt->creation_time.addMSecs(millisecs);
         if (global_opts.debug_level > 1) {
-          time_t t = wpt->GetCreationTime().toTime_t();
+          time_t t = wpt->creation_time.toTime_t();
           strftime(tbuffer, sizeof(tbuffer), "%c", gmtime(&t));
           printf("parsed timestamp: %s\n",tbuffer);
         }
@@ -310,7 +310,7 @@ gopal_read()
     double speed = 0;
     if (lastwpt !=nullptr) {
       speed=3.6*radtometers(gcdist(RAD(lastwpt->latitude), RAD(lastwpt->longitude), RAD(wpt->latitude), RAD(wpt->longitude))) /
-            abs((int)(wpt->creation_time.toTime_t() - lastwpt->GetCreationTime().toTime_t()));
+            abs((int)(wpt->creation_time.toTime_t() - lastwpt->creation_time.toTime_t()));
       //printf("speed line %d %lf \n",line,speed);
     }
     /* Error handling: in the tracklog of my device sometimes "jump" waypoints ;-) */
@@ -351,7 +351,7 @@ gopal_write_waypt(const Waypoint* wpt)
   int fix=fix_unknown;
   //TICK;    TIME;   LONG;     LAT;       HEIGHT; SPEED;  UN; HDOP;     SAT
   //3801444, 080558, 2.944362, 43.262117, 295.28, 0.12964, 2, 2.900000, 3
-  snprintf(tbuffer, sizeof(tbuffer), "%06d", wpt->creation_time.hms());
+  snprintf(tbuffer, sizeof(tbuffer), "%06d", wpt->GetCreationTime().hms());
   if (wpt->fix!=fix_unknown) {
     switch (wpt->fix) {
     case fix_none:
@@ -366,7 +366,7 @@ gopal_write_waypt(const Waypoint* wpt)
     }
   }
   //MSVC handles time_t as int64, gcc and mac only int32, so convert it:
-  unsigned long timestamp = (unsigned long)wpt->GetCreationTime().toTime_t();
+  unsigned long timestamp = (unsigned long)wpt->creation_time.toTime_t();
   gbfprintf(fout, "%lu, %s, %lf, %lf, %5.1lf, %8.5lf, %d, %lf, %d\n",timestamp,tbuffer,  wpt->longitude, wpt->latitude,wpt->altitude,
             wpt->speed,fix,wpt->hdop,wpt->sat);
 }
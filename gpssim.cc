@@ -125,7 +125,7 @@ gpssim_write_pt(const Waypoint* wpt)
   if (wpt->creation_time.isValid()) {
     char tbuf[20];
 
-    const time_t tt = wpt->GetCreationTime().toTime_t();
+    const time_t tt = wpt->creation_time.toTime_t();
     struct tm* tm = gmtime(&tt);
     int hms = tm->tm_hour * 10000 + tm->tm_min * 100 + tm->tm_sec;
     int ymd = tm->tm_mday * 10000 + tm->tm_mon * 100 + tm->tm_year;
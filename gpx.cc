@@ -24,15 +24,16 @@
 #include <cstdlib>                                 // for atoi, strtod
 #include <cstring>                                 // for strchr, strncpy
 
+#include <QtCore/QByteArray>                       // for QByteArray
 #include <QtCore/QDate>                            // for QDate
 #include <QtCore/QDateTime>                        // for QDateTime
-#include <QtCore/QHash>                            // for QHash
 #include <QtCore/QIODevice>                        // for QIODevice, operator|, QIODevice::ReadOnly, QIODevice::Text, QIODevice::WriteOnly
 #include <QtCore/QLatin1String>                    // for QLatin1String
 #include <QtCore/QStaticStringData>                // for QStaticStringData
 #include <QtCore/QString>                          // for QString, QStringLiteral, operator+, operator==
 #include <QtCore/QStringList>                      // for QStringList
 #include <QtCore/QStringRef>                       // for QStringRef
+#include <QtCore/QTemporaryFile>                   // for QTemporaryFile
 #include <QtCore/QTime>                            // for QTime
 #include <QtCore/QVector>                          // for QVector
 #include <QtCore/QXmlStreamAttribute>              // for QXmlStreamAttribute
@@ -49,6 +50,7 @@
 #include "src/core/datetime.h"
 #include "src/core/file.h"
 #include "src/core/logging.h"
+#include "src/core/numberformat.h"
 #include "src/core/xmlstreamwriter.h"
 #include "src/core/xmltag.h"
 
@@ -69,8 +71,6 @@ static char* gpx_wversion;
 static int gpx_wversion_num;
 static QXmlStreamAttributes gpx_namespace_attribute;
 
-static QString current_tag;
-
 static Waypoint* wpt_tmp;
 static UrlLink* link_;
 static UrlLink* rh_link_;
@@ -79,6 +79,9 @@ static gpsbabel::File* iqfile;
 static gpsbabel::File* oqfile;
 static gpsbabel::XmlStreamWriter* writer;
 static short_handle mkshort_handle;
+/* tracks streamed before the file is written */
+static QTemporaryFile* spool;
+static gpsbabel::XmlStreamWriter* spool_writer;
 static QString link_url;
 static QString link_text;
 static QString link_type;
@@ -90,6 +93,7 @@ static char* urlbase = nullptr;
 static route_head* trk_head;
 static route_head* rte_head;
 static const route_head* current_trk_head;		// Output.
+static int current_trk_wpt_ct;			// Output.
 /* used for bounds calculation on output */
 static bounds all_bounds;
 static int next_trkpt_is_new_seg;
@@ -246,12 +250,12 @@ gpx_add_to_global(QStringList& ge, const QString& s)
 // zillion reference files.
 static inline QString toString(double d)
 {
-  return QString::number(d, 'f', 9);
+  return gpsbabel::formatFixed(d, 9);
 }
 
 static inline QString toString(float f)
 {
-  return QString::number(f, 'f', 6);
+  return gpsbabel::formatFixed(f, 6);
 }
 
 
@@ -447,16 +451,48 @@ static tag_mapping tag_path_map[] = {
   {(tag_type)0, 0, nullptr}
 };
 
-// Maintain a fast mapping from full tag names to the struct above.
-static QHash<QString, tag_mapping*> hash;
+/*
+ * The paths above are interned into a tree keyed by element name, one
+ * level per path component.  While reading we keep a stack of the nodes
+ * for the open elements, so each start element costs one scan of its
+ * parent's (short) child list instead of building and hashing the full
+ * path.  Once we step outside the tree every descendant is unknown, which
+ * makes deep extension subtrees under trkpt nearly free.
+ */
+struct tag_node {
+  QString name;
+  const tag_mapping* tm{nullptr};
+  QVector<tag_node*> children;
+
+  tag_node() = default;
+  explicit tag_node(const QString& n) : name(n) {}
+  tag_node(const tag_node&) = delete;
+  tag_node& operator=(const tag_node&) = delete;
+  ~tag_node()
+  {
+    qDeleteAll(children);
+  }
+
+  const tag_node* find_child(const QStringRef& el) const
+  {
+    for (const tag_node* child : children) {
+      if (child->name == el) {
+        return child;
+      }
+    }
+    return nullptr;
+  }
+};
+
+static tag_node tag_tree;
+static QVector<const tag_node*> tag_stack;
 
 static tag_type
-get_tag(const QString& t, int* passthrough)
+get_tag(const tag_node* node, int* passthrough)
 {
-  tag_mapping* tm = hash[t];
-  if (tm) {
-    *passthrough = tm->tag_passthrough;
-    return tm->tag_type_;
+  if (node && node->tm) {
+    *passthrough = node->tm->tag_passthrough;
+    return node->tm->tag_type_;
   }
   *passthrough = 1;
   return tt_unknown;
@@ -465,8 +501,27 @@ get_tag(const QString& t, int* passthrough)
 static void
 prescan_tags()
 {
-  for (tag_mapping* tm = tag_path_map; tm->tag_type_ != 0; tm++) {
-    hash[tm->tag_name] = tm;
+  if (!tag_tree.children.isEmpty()) {
+    return;
+  }
+  for (const tag_mapping* tm = tag_path_map; tm->tag_type_ != 0; tm++) {
+    tag_node* node = &tag_tree;
+    const QStringList parts = QString(tm->tag_name).split('/', QString::SkipEmptyParts);
+    for (const auto& part : parts) {
+      tag_node* next = nullptr;
+      for (tag_node* child : qAsConst(node->children)) {
+        if (child->name == part) {
+          next = child;
+          break;
+        }
+      }
+      if (next == nullptr) {
+        next = new tag_node(part);
+        node->children.append(next);
+      }
+      node = next;
+    }
+    node->tm = tm;
   }
 }
 
@@ -507,10 +562,10 @@ tag_wpt(const QXmlStreamAttributes& attr)
 
   cur_tag = nullptr;
   if (attr.hasAttribute("lat")) {
-    wpt_tmp->latitude = attr.value("lat").toString().toDouble();
+    wpt_tmp->latitude = attr.value("lat").toDouble();
   }
   if (attr.hasAttribute("lon")) {
-    wpt_tmp->longitude = attr.value("lon").toString().toDouble();
+    wpt_tmp->longitude = attr.value("lon").toDouble();
   }
   fs_ptr = &wpt_tmp->fs;
 }
@@ -551,14 +606,14 @@ tag_gs_cache(const QXmlStreamAttributes& attr)
 }
 
 static void
-start_something_else(const QString& el, const QXmlStreamAttributes& attr)
+start_something_else(const QStringRef& el, const QXmlStreamAttributes& attr)
 {
   if (!fs_ptr) {
     return;
   }
 
   xml_tag* new_tag = new xml_tag;
-  new_tag->tagname = el;
+  new_tag->tagname = el.toString();
 
   int attr_count = attr.size();
   const QXmlStreamNamespaceDeclarations nsdecl = reader->namespaceDeclarations();
@@ -656,7 +711,7 @@ tag_log_wpt(const QXmlStreamAttributes& attr)
 }
 
 static void
-gpx_start(const QString& el, const QXmlStreamAttributes& attr)
+gpx_start(const tag_node* node, const QStringRef& el, const QXmlStreamAttributes& attr)
 {
   int passthrough;
 
@@ -665,7 +720,7 @@ gpx_start(const QString& el, const QXmlStreamAttributes& attr)
    */
   cdatastr = QString();
 
-  int tag = get_tag(current_tag, &passthrough);
+  int tag = get_tag(node, &passthrough);
   switch (tag) {
   case tt_gpx:
     tag_gpx(attr);
@@ -832,9 +887,123 @@ gs_get_container(geocache_container t)
   return "Unknown";
 }
 
+/*
+ * Fast path for the strict RFC 3339 form that nearly every writer
+ * produces: YYYY-MM-DDThh:mm:ss[.frac][Z|+hh:mm|-hh:mm].  The result
+ * goes straight to milliseconds since the epoch without building any
+ * intermediate QDate/QTime.  Anything else, including out of range
+ * fields, returns false and is left to the forgiving parser below.
+ */
+static bool
+xml_parse_time_rfc3339(const QString& str, qint64* msecs)
+{
+  const QChar* s = str.constData();
+  const int len = str.size();
+
+  // Value of the n digits at s[pos], or -1 if any of them isn't a digit.
+  auto digits = [s](int pos, int n) {
+    int v = 0;
+    for (int i = pos; i < pos + n; i++) {
+      unsigned int d = s[i].unicode() - '0';
+      if (d > 9) {
+        return -1;
+      }
+      v = v * 10 + d;
+    }
+    return v;
+  };
+
+  if (len < 19 || s[4] != '-' || s[7] != '-' || s[10] != 'T' ||
+      s[13] != ':' || s[16] != ':') {
+    return false;
+  }
+  const int year = digits(0, 4);
+  const int mon = digits(5, 2);
+  const int mday = digits(8, 2);
+  const int hour = digits(11, 2);
+  const int min = digits(14, 2);
+  const int sec = digits(17, 2);
+  if (year < 1 || mon < 1 || mon > 12 || mday < 1 ||
+      hour < 0 || hour > 23 || min < 0 || min > 59 || sec < 0 || sec > 59) {
+    return false;
+  }
+  static const int mdays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  const bool leap = (year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0));
+  if (mday > mdays[mon - 1] + ((mon == 2 && leap) ? 1 : 0)) {
+    return false;
+  }
+
+  int pos = 19;
+  qint64 frac_ms = 0;
+  if (pos < len && s[pos] == '.') {
+    int end = pos + 1;
+    while (end < len && digits(end, 1) >= 0) {
+      end++;
+    }
+    const int ndigits = end - pos - 1;
+    if (ndigits == 0) {
+      return false;
+    }
+    if (ndigits <= 3) {
+      frac_ms = digits(pos + 1, ndigits);
+      for (int i = ndigits; i < 3; i++) {
+        frac_ms *= 10;
+      }
+    } else {
+      // Round exactly the way the slow path does.
+      char buf[32];
+      if (ndigits + 2 > static_cast<int>(sizeof(buf))) {
+        return false;
+      }
+      for (int i = pos; i < end; i++) {
+        buf[i - pos] = s[i].toLatin1();
+      }
+      buf[end - pos] = '\0';
+      frac_ms = lround(strtod(buf, nullptr) * 1000);
+    }
+    pos = end;
+  }
+
+  int offset = 0;
+  if (pos < len) {
+    if (s[pos] == 'Z' && pos + 1 == len) {
+      // zulu time, no offset
+    } else if ((s[pos] == '+' || s[pos] == '-') && pos + 6 == len &&
+               s[pos + 3] == ':') {
+      const int off_hr = digits(pos + 1, 2);
+      const int off_min = digits(pos + 4, 2);
+      if (off_hr < 0 || off_min < 0) {
+        return false;
+      }
+      offset = off_hr * 3600 + off_min * 60;
+      if (s[pos] == '-') {
+        offset = -offset;
+      }
+    } else {
+      return false;
+    }
+  }
+
+  // Days since 1970-01-01 in the proleptic Gregorian calendar.
+  const int y = year - (mon <= 2 ? 1 : 0);
+  const int era = y / 400;
+  const int yoe = y - era * 400;
+  const int doy = (153 * (mon + (mon > 2 ? -3 : 9)) + 2) / 5 + mday - 1;
+  const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  const qint64 days = qint64(era) * 146097 + doe - 719468;
+
+  *msecs = (days * 86400 + hour * 3600 + min * 60 + sec - offset) * 1000 + frac_ms;
+  return true;
+}
+
 gpsbabel::DateTime
 xml_parse_time(const QString& dateTimeString)
 {
+  qint64 msecs;
+  if (xml_parse_time_rfc3339(dateTimeString, &msecs)) {
+    return QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC);
+  }
+
   int off_hr = 0;
   int off_min = 0;
   int off_sign = 1;
@@ -901,7 +1070,7 @@ xml_parse_time(const QString& dateTimeString)
 }
 
 static void
-gpx_end(const QString&)
+gpx_end(const tag_node* node)
 {
   float x;
   int passthrough;
@@ -910,7 +1079,7 @@ gpx_end(const QString&)
   // Remove leading, trailing whitespace.
   cdatastr = cdatastr.trimmed();
 
-  tag_type tag = get_tag(current_tag, &passthrough);
+  tag_type tag = get_tag(node, &passthrough);
 
   switch (tag) {
   /*
@@ -1273,7 +1442,7 @@ gpx_rd_init(const QString& fname)
   iqfile->open(QIODevice::ReadOnly);
   reader = new QXmlStreamReader(iqfile);
 
-  current_tag.clear();
+  tag_stack.clear();
 
   prescan_tags();
 
@@ -1300,16 +1469,8 @@ gpx_rd_deinit()
 }
 
 static void
-gpx_wr_init(const QString& fname)
+gpx_wr_version()
 {
-  mkshort_handle = nullptr;
-  oqfile = new gpsbabel::File(fname);
-  oqfile->open(QIODevice::WriteOnly | QIODevice::Text);
-
-  writer = new gpsbabel::XmlStreamWriter(oqfile);
-  writer->setAutoFormattingIndent(2);
-  writer->writeStartDocument();
-
   /* if an output version is not specified and an input version is
   * available use it, otherwise use the default.
   */
@@ -1339,6 +1500,20 @@ gpx_wr_init(const QString& fname)
     Fatal() << MYNAME << ": gpx version number of "
             << gpx_wversion << "not valid.";
   }
+}
+
+static void
+gpx_wr_init(const QString& fname)
+{
+  mkshort_del_handle(&mkshort_handle);
+  oqfile = new gpsbabel::File(fname);
+  oqfile->open(QIODevice::WriteOnly | QIODevice::Text);
+
+  writer = new gpsbabel::XmlStreamWriter(oqfile);
+  writer->setAutoFormattingIndent(2);
+  writer->writeStartDocument();
+
+  gpx_wr_version();
 
   // FIXME: This write of a blank line is needed for Qt 4.6 (as on Centos 6.3)
   // to include just enough whitespace between <xml/> and <gpx...> to pass
@@ -1437,19 +1612,20 @@ gpx_read()
     reader->readNext();
     // do processing
     switch (reader->tokenType()) {
-    case QXmlStreamReader::StartElement:
-      current_tag.append("/");
-      current_tag.append(reader->qualifiedName());
-
-      {
-        const QXmlStreamAttributes attrs = reader->attributes();
-        gpx_start(reader->qualifiedName().toString(), attrs);
-      }
-      break;
+    case QXmlStreamReader::StartElement: {
+      const QStringRef el = reader->qualifiedName();
+      const tag_node* parent = tag_stack.isEmpty() ? &tag_tree : tag_stack.last();
+      const tag_node* node = parent ? parent->find_child(el) : nullptr;
+      tag_stack.append(node);
+
+      const QXmlStreamAttributes attrs = reader->attributes();
+      gpx_start(node, el, attrs);
+    }
+    break;
 
     case QXmlStreamReader::EndElement:
-      gpx_end(reader->qualifiedName().toString());
-      current_tag.chop(reader->qualifiedName().length() + 1);
+      gpx_end(tag_stack.last());
+      tag_stack.removeLast();
       cdatastr.clear();
       break;
 
@@ -1661,7 +1837,7 @@ static void
 gpx_write_common_position(const Waypoint* waypointp, const gpx_point_type point_type)
 {
   if (waypointp->altitude != unknown_alt) {
-    writer->writeTextElement(QStringLiteral("ele"), QString::number(waypointp->altitude, 'f', elevation_precision));
+    writer->writeTextElement(QStringLiteral("ele"), gpsbabel::formatFixed(waypointp->altitude, elevation_precision));
   }
   QString t = waypointp->CreationTimeXML();
   writer->writeOptionalTextElement(QStringLiteral("time"), t);
@@ -1801,6 +1977,7 @@ static void
 gpx_track_hdr(const route_head* rte)
 {
   current_trk_head = rte;
+  current_trk_wpt_ct = 0;
 
   writer->writeStartElement(QStringLiteral("trk"));
   writer->writeOptionalTextElement(QStringLiteral("name"), rte->rte_name);
@@ -1836,7 +2013,9 @@ gpx_track_hdr(const route_head* rte)
 static void
 gpx_track_disp(const Waypoint* waypointp)
 {
-  bool first_in_trk = waypointp == current_trk_head->waypoint_list.front();
+  // Count rather than compare with the list, a streamed track has
+  // already dropped the points written before.
+  bool first_in_trk = current_trk_wpt_ct++ == 0;
 
   if (waypointp->wpt_flags.new_trkseg) {
     if (!first_in_trk) {
@@ -1873,7 +2052,7 @@ gpx_track_disp(const Waypoint* waypointp)
 static void
 gpx_track_tlr(const route_head*)
 {
-  if (!current_trk_head->waypoint_list.empty()) {
+  if (current_trk_wpt_ct > 0) {
     writer->writeEndElement();
   }
 
@@ -1976,6 +2155,9 @@ gpx_write_bounds()
   waypt_disp_all(gpx_waypt_bound_calc);
   route_disp_all(nullptr, nullptr, gpx_waypt_bound_calc);
   track_disp_all(nullptr, nullptr, gpx_waypt_bound_calc);
+  if (spool != nullptr) {
+    track_stream_add_bounds(&all_bounds);
+  }
 
   if (waypt_bounds_valid(&all_bounds)) {
     writer->writeStartElement(QStringLiteral("bounds"));
@@ -1987,6 +2169,51 @@ gpx_write_bounds()
   }
 }
 
+/*
+ * Streamed tracks are written to a spool while the input is read, by a
+ * writer of their own that stands in for the one of the file.  Its gpx
+ * element has the same depth as the real one, so once the waypoints and
+ * routes are written the tracks can be copied over as they are.
+ */
+static void
+gpx_wr_begin()
+{
+  gpx_wr_version();
+  elevation_precision = atoi(opt_elevation_precision);
+  gpx_reset_short_handle();
+
+  spool = new QTemporaryFile;
+  if (!spool->open()) {
+    fatal(MYNAME ": Cannot open a temporary file for the tracks.\n");
+  }
+  spool_writer = new gpsbabel::XmlStreamWriter(spool);
+  spool_writer->setAutoFormattingIndent(2);
+  spool_writer->setAutoFormatting(true);
+  spool_writer->writeStartElement(QStringLiteral("gpx"));
+  writer = spool_writer;
+}
+
+static void
+gpx_write_spool()
+{
+  delete spool_writer;
+  spool_writer = nullptr;
+
+  /* Skip the spool's own gpx start tag, the rest are the trk elements. */
+  spool->flush();
+  spool->seek(0);
+  QByteArray buf = spool->read(64 * 1024);
+  int start = buf.indexOf('>');
+  if (start >= 0) {
+    oqfile->write(buf.constData() + start + 1, buf.size() - start - 1);
+    while (!spool->atEnd()) {
+      oqfile->write(spool->read(64 * 1024));
+    }
+  }
+  delete spool;
+  spool = nullptr;
+}
+
 static void
 gpx_write()
 {
@@ -1998,6 +2225,9 @@ gpx_write()
   gpx_reset_short_handle();
   gpx_route_pr();
   gpx_reset_short_handle();
+  if (spool != nullptr) {
+    gpx_write_spool();
+  }
   gpx_track_pr();
   writer->writeEndElement(); // Close gpx tag.
 }
@@ -2069,4 +2299,8 @@ ff_vecs_t gpx_vecs = {
   CET_CHARSET_UTF8, 0,	/* non-fixed to create non UTF-8 XML's for testing | CET-REVIEW */
   NULL_POS_OPS,
   nullptr,
+  {
+    nullptr,
+    gpx_wr_begin, gpx_track_hdr, gpx_track_tlr, gpx_track_disp
+  }
 };
@@ -66,14 +66,19 @@ double radtometers(double rads)
   return (rads * EARTH_RAD);
 }
 
-double gcdist(double lat1, double lon1, double lat2, double lon2)
+/*
+ * The single leg workers, with the cosine (and for the heading, the sine)
+ * of each latitude passed in so that gcdist_heading_path() can share them.
+ */
+static double gcdist_sc(double lat1, double lon1, double clat1,
+                        double lat2, double lon2, double clat2)
 {
   errno = 0;
 
   double sdlat = sin((lat1 - lat2) / 2.0);
   double sdlon = sin((lon1 - lon2) / 2.0);
 
-  double res = sqrt(sdlat * sdlat + cos(lat1) * cos(lat2) * sdlon * sdlon);
+  double res = sqrt(sdlat * sdlat + clat1 * clat2 * sdlon * sdlon);
 
   if (res > 1.0) {
     res = 1.0;
@@ -91,13 +96,11 @@ double gcdist(double lat1, double lon1, double lat2, double lon2)
   return 2.0 * res;
 }
 
-/* This value is the heading you'd leave point 1 at to arrive at point 2.
- * Inputs and outputs are in radians.
- */
-double heading(double lat1, double lon1, double lat2, double lon2)
+static double heading_sc(double slat1, double clat1, double lon1,
+                         double slat2, double clat2, double lon2)
 {
-  double v1 = sin(lon1 - lon2) * cos(lat2);
-  double v2 = cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(lon1 - lon2);
+  double v1 = sin(lon1 - lon2) * clat2;
+  double v2 = clat1 * slat2 - slat1 * clat2 * cos(lon1 - lon2);
   /* rounding error protection */
   if (fabs(v1) < 1e-15) {
     v1 = 0.0;
@@ -108,10 +111,9 @@ double heading(double lat1, double lon1, double lat2, double lon2)
   return atan2(v1, v2);
 }
 
-/* As above, but outputs is in degrees from 0 - 359.  Inputs are still radians. */
-double heading_true_degrees(double lat1, double lon1, double lat2, double lon2)
+static double true_degrees(double heading)
 {
-  double h = 360.0 - DEG(heading(lat1, lon1, lat2, lon2));
+  double h = 360.0 - DEG(heading);
   if (h >= 360.0) {
     h -= 360.0;
   }
@@ -119,6 +121,52 @@ double heading_true_degrees(double lat1, double lon1, double lat2, double lon2)
   return h;
 }
 
+double gcdist(double lat1, double lon1, double lat2, double lon2)
+{
+  return gcdist_sc(lat1, lon1, cos(lat1), lat2, lon2, cos(lat2));
+}
+
+/* This value is the heading you'd leave point 1 at to arrive at point 2.
+ * Inputs and outputs are in radians.
+ */
+double heading(double lat1, double lon1, double lat2, double lon2)
+{
+  return heading_sc(sin(lat1), cos(lat1), lon1, sin(lat2), cos(lat2), lon2);
+}
+
+/* As above, but outputs is in degrees from 0 - 359.  Inputs are still radians. */
+double heading_true_degrees(double lat1, double lon1, double lat2, double lon2)
+{
+  return true_degrees(heading(lat1, lon1, lat2, lon2));
+}
+
+/* gcdist() and heading_true_degrees() for each leg of a path of n points.
+ * dist[i] and course[i] describe the leg from point i to point i + 1.
+ * Every latitude's sine and cosine is computed once, for both legs
+ * meeting at the point and for both results; the answers are exactly
+ * those of the single leg functions.  Inputs are radians.
+ */
+void gcdist_heading_path(int n, const double* lat, const double* lon,
+                         double* dist, double* course)
+{
+  if (n < 2) {
+    return;
+  }
+
+  double slat1 = sin(lat[0]);
+  double clat1 = cos(lat[0]);
+  for (int i = 1; i < n; i++) {
+    double slat2 = sin(lat[i]);
+    double clat2 = cos(lat[i]);
+    course[i - 1] = true_degrees(heading_sc(slat1, clat1, lon[i - 1],
+                                            slat2, clat2, lon[i]));
+    dist[i - 1] = gcdist_sc(lat[i - 1], lon[i - 1], clat1,
+                            lat[i], lon[i], clat2);
+    slat1 = slat2;
+    clat1 = clat2;
+  }
+}
+
 double linedistprj(double lat1, double lon1,
                    double lat2, double lon2,
                    double lat3, double lon3,
@@ -25,6 +25,8 @@
 double gcdist(double lat1, double lon1, double lat2, double lon2);
 double heading(double lat1, double lon1, double lat2, double lon2);
 double heading_true_degrees(double lat1, double lon1, double lat2, double lon2);
+void gcdist_heading_path(int n, const double* lat, const double* lon,
+                         double* dist, double* course);
 
 double linedistprj(double lat1, double lon1,
                    double lat2, double lon2,
@@ -274,7 +274,7 @@ gtc_study_lap(const Waypoint* wpt)
     gtc_start_lat = wpt->latitude;
     gtc_start_long = wpt->longitude;
   }
-  if (wpt->creation_time > gtc_most_time)  {
+  if (wpt->GetCreationTime() > gtc_most_time)  {
     gtc_most_time = wpt->GetCreationTime();
     gtc_end_lat = wpt->latitude;
     gtc_end_long = wpt->longitude;
@@ -38,6 +38,15 @@ public:
   }
   void init() override;
   void process() override;
+  bool stream_capable() override
+  {
+    return true;
+  }
+  bool stream_point(Waypoint* wpt) override
+  {
+    correct_height(wpt);
+    return true;
+  }
 
 private:
   char* addopt        = nullptr;
@@ -697,7 +697,7 @@ humminbird_write_waypoint(const Waypoint* wpt)
   hum.depth = si_round(WAYPT_GET(wpt, depth, 0)*100.0);
   be_write16(&hum.depth, hum.depth);
 
-  be_write32(&hum.time, wpt->GetCreationTime().toTime_t());
+  be_write32(&hum.time, wpt->creation_time.toTime_t());
 
   double east = wpt->longitude / 180.0 * EAST_SCALE;
   be_write32(&hum.east, si_round((east)));
@@ -791,7 +791,7 @@ humminbird_track_cb(const Waypoint* wpt)
   int32_t north = si_round(inverse_gudermannian_i1924(lat));
 
   if (wpt->creation_time.isValid()) {
-    last_time = wpt->GetCreationTime().toTime_t();
+    last_time = wpt->creation_time.toTime_t();
   }
 
   if (i == 0) {
@@ -603,7 +603,7 @@ static void wr_header()
   }
   // Date in header record is that of the first fix record
   date = !track ? current_time().toTime_t() :
-         track->waypoint_list.front()->GetCreationTime().toTime_t();
+         track->waypoint_list.front()->creation_time.toTime_t();
 
   if (nullptr == (tm = gmtime(&date))) {
     fatal(MYNAME ": Bad track timestamp\n");
@@ -690,7 +690,7 @@ static void wr_task_hdr(const route_head* rte)
     fatal(MYNAME ": Too much waypoints (more than 99) in task route.\n");
   }
   // Gather data to write to the task identification (first) record
-  rte_time = wpt->GetCreationTime().isValid() ? wpt->GetCreationTime().toTime_t() : current_time().toTime_t();
+  rte_time = wpt->creation_time.isValid() ? wpt->creation_time.toTime_t() : current_time().toTime_t();
   if (nullptr == (tm = gmtime(&rte_time))) {
     fatal(MYNAME ": Bad task route timestamp\n");
   }
@@ -735,7 +735,7 @@ static void wr_tasks()
  */
 static void wr_fix_record(const Waypoint* wpt, int pres_alt, int gnss_alt)
 {
-  const time_t tt = wpt->GetCreationTime().toTime_t();
+  const time_t tt = wpt->creation_time.toTime_t();
   struct tm* tm = gmtime(&tt);
 
   if (nullptr == tm) {
@@ -784,7 +784,7 @@ static int correlate_tracks(const route_head* pres_track, const route_head* gnss
       return 0;
     }
   } while (alt_diff > -10.0);
-  pres_time = (*std::prev(wpt_rit))->GetCreationTime().toTime_t();
+  pres_time = (*std::prev(wpt_rit))->creation_time.toTime_t();
   if (global_opts.debug_level >= 1) {
     printf(MYNAME ": pressure landing time %s", ctime(&pres_time));
   }
@@ -800,7 +800,7 @@ static int correlate_tracks(const route_head* pres_track, const route_head* gnss
       return 0;
     }
     // Get a crude indication of groundspeed from the change in lat/lon
-    time_diff = wpt->GetCreationTime().toTime_t() - (*wpt_rit)->GetCreationTime().toTime_t();
+    time_diff = wpt->creation_time.toTime_t() - (*wpt_rit)->creation_time.toTime_t();
     speed = !time_diff ? 0 :
             (fabs(wpt->latitude - (*wpt_rit)->latitude) +
              fabs(wpt->longitude - (*wpt_rit)->longitude)) / time_diff;
@@ -808,7 +808,7 @@ static int correlate_tracks(const route_head* pres_track, const route_head* gnss
       printf(MYNAME ": speed=%f\n", speed);
     }
   } while (speed < 0.00003);
-  gnss_time = (*std::prev(wpt_rit))->GetCreationTime().toTime_t();
+  gnss_time = (*std::prev(wpt_rit))->creation_time.toTime_t();
   if (global_opts.debug_level >= 1) {
     printf(MYNAME ": gnss landing time %s", ctime(&gnss_time));
   }
@@ -838,7 +838,7 @@ static double interpolate_alt(const route_head* track, time_t time)
   }
   // Find the track points either side of the requested time
   while ((track->waypoint_list.cend() != curr_wpt.value()) &&
-         ((*curr_wpt.value())->GetCreationTime().toTime_t() < time)) {
+         ((*curr_wpt.value())->creation_time.toTime_t() < time)) {
     prev_wpt = curr_wpt.value();
     curr_wpt = std::next(prev_wpt.value());
   }
@@ -848,7 +848,7 @@ static double interpolate_alt(const route_head* track, time_t time)
   }
 
   if (track->waypoint_list.cbegin() == curr_wpt.value()) {
-    if ((*curr_wpt.value())->GetCreationTime().toTime_t() == time) {
+    if ((*curr_wpt.value())->creation_time.toTime_t() == time) {
       // First point's creation time is an exact match so use it's altitude
       return (*curr_wpt.value())->altitude;
     } else {
@@ -857,12 +857,12 @@ static double interpolate_alt(const route_head* track, time_t time)
     }
   }
   // Interpolate
-  if (0 == (time_diff = (*curr_wpt.value())->GetCreationTime().toTime_t() - (*prev_wpt.value())->GetCreationTime().toTime_t())) {
+  if (0 == (time_diff = (*curr_wpt.value())->creation_time.toTime_t() - (*prev_wpt.value())->creation_time.toTime_t())) {
     // Avoid divide by zero
     return (*curr_wpt.value())->altitude;
   }
   double alt_diff = (*curr_wpt.value())->altitude - (*prev_wpt.value())->altitude;
-  return (*prev_wpt.value())->altitude + (alt_diff / time_diff) * (time - (*prev_wpt.value())->GetCreationTime().toTime_t());
+  return (*prev_wpt.value())->altitude + (alt_diff / time_diff) * (time - (*prev_wpt.value())->creation_time.toTime_t());
 }
 
 /*
@@ -894,7 +894,7 @@ static void wr_track()
     }
     // Iterate through waypoints in both tracks simultaneously
     foreach (const Waypoint* wpt, gnss_track->waypoint_list) {
-      double pres_alt = interpolate_alt(pres_track, wpt->GetCreationTime().toTime_t() + time_adj);
+      double pres_alt = interpolate_alt(pres_track, wpt->creation_time.toTime_t() + time_adj);
       wr_fix_record(wpt, pres_alt, wpt->altitude);
     }
   } else {
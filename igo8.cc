@@ -214,7 +214,7 @@ static void write_igo8_track_point(const Waypoint* wpt)
   // then we shall make our own, where each point is one
   // second apart.
   if (wpt->creation_time.isValid()) {
-    le_write32(&point.unix_time, wpt->GetCreationTime().toTime_t());
+    le_write32(&point.unix_time, wpt->creation_time.toTime_t());
   } else {
     le_write32(&point.unix_time, invented_time++);
   }
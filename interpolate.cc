@@ -34,13 +34,88 @@
 #if FILTERS_ENABLED
 #define MYNAME "Interpolate filter"
 
+void InterpolateFilter::add_wpt(route_head* rte, Waypoint* wpt)
+{
+  if (rte == nullptr) {
+    track_stream_insert(wpt);
+  } else if (opt_route) {
+    route_add_wpt(rte, wpt);
+  } else {
+    track_add_wpt(rte, wpt);
+  }
+}
+
+/*
+ * Add the points between the one before and this one to rte_new, or
+ * hand them on to the stream if there is no rte_new.
+ */
+void InterpolateFilter::interpolate_wpt(const Waypoint* wpt, route_head* rte_new)
+{
+  double frac;
+
+  if (first) {
+    first = false;
+  } else {
+    if (opt_interval &&
+        wpt->creation_time.toTime_t() - time1 > interval) {
+      for (unsigned int timen = time1+interval;
+           timen < wpt->creation_time.toTime_t();
+           timen += interval) {
+        Waypoint* wpt_new = new Waypoint(*wpt);
+        wpt_new->SetCreationTime(timen);
+        wpt_new->shortname = QString();
+        wpt_new->description = QString();
+
+        frac = (double)(timen - time1) / (double)(wpt->creation_time.toTime_t() - time1);
+        linepart(lat1, lon1,
+                 wpt->latitude, wpt->longitude,
+                 frac,
+                 &wpt_new->latitude,
+                 &wpt_new->longitude);
+        if (altitude1 != unknown_alt && wpt->altitude != unknown_alt) {
+          wpt_new->altitude = altitude1 + frac * (wpt->altitude - altitude1);
+        }
+        add_wpt(rte_new, wpt_new);
+      }
+    } else if (opt_dist) {
+      double rt1 = RAD(lat1);
+      double rn1 = RAD(lon1);
+      double rt2 = RAD(wpt->latitude);
+      double rn2 = RAD(wpt->longitude);
+      double curdist = gcdist(rt1, rn1, rt2, rn2);
+      curdist = radtomiles(curdist);
+      if (curdist > dist) {
+        for (double distn = dist;
+             distn < curdist;
+             distn += dist) {
+          Waypoint* wpt_new = new Waypoint(*wpt);
+          frac = distn / curdist;
+          wpt_new->SetCreationTime(frac * (wpt->creation_time.toTime_t() - time1) + time1);
+          wpt_new->shortname = QString();
+          wpt_new->description = QString();
+          linepart(lat1, lon1,
+                   wpt->latitude, wpt->longitude,
+                   frac,
+                   &wpt_new->latitude,
+                   &wpt_new->longitude);
+          if (altitude1 != unknown_alt && wpt->altitude != unknown_alt) {
+            wpt_new->altitude = altitude1 + frac * (wpt->altitude - altitude1);
+          }
+          add_wpt(rte_new, wpt_new);
+        }
+      }
+    }
+  }
+
+  lat1 = wpt->latitude;
+  lon1 = wpt->longitude;
+  altitude1 = wpt->altitude;
+  time1 = wpt->creation_time.toTime_t();
+}
+
 void InterpolateFilter::process()
 {
   RouteList* backuproute = nullptr;
-  double lat1 = 0, lon1 = 0;
-  double altitude1 = unknown_alt;
-  unsigned int time1 = 0;
-  double frac;
 
   if (opt_route) {
     route_backup(&backuproute);
@@ -66,87 +141,47 @@ void InterpolateFilter::process()
     } else {
       track_add_head(rte_new);
     }
-    bool first = true;
+    first = true;
     foreach (const Waypoint* wpt, rte_old->waypoint_list) {
-      if (first) {
-        first = false;
-      } else {
-        if (opt_interval &&
-            wpt->creation_time.toTime_t() - time1 > interval) {
-          for (unsigned int timen = time1+interval;
-               timen < wpt->creation_time.toTime_t();
-               timen += interval) {
-            Waypoint* wpt_new = new Waypoint(*wpt);
-            wpt_new->SetCreationTime(timen);
-            wpt_new->shortname = QString();
-            wpt_new->description = QString();
-
-            frac = (double)(timen - time1) / (double)(wpt->creation_time.toTime_t() - time1);
-            linepart(lat1, lon1,
-                     wpt->latitude, wpt->longitude,
-                     frac,
-                     &wpt_new->latitude,
-                     &wpt_new->longitude);
-            if (altitude1 != unknown_alt && wpt->altitude != unknown_alt) {
-              wpt_new->altitude = altitude1 + frac * (wpt->altitude - altitude1);
-            }
-            if (opt_route) {
-              route_add_wpt(rte_new, wpt_new);
-            } else {
-              track_add_wpt(rte_new, wpt_new);
-            }
-          }
-        } else if (opt_dist) {
-          double rt1 = RAD(lat1);
-          double rn1 = RAD(lon1);
-          double rt2 = RAD(wpt->latitude);
-          double rn2 = RAD(wpt->longitude);
-          double curdist = gcdist(rt1, rn1, rt2, rn2);
-          curdist = radtomiles(curdist);
-          if (curdist > dist) {
-            for (double distn = dist;
-                 distn < curdist;
-                 distn += dist) {
-              Waypoint* wpt_new = new Waypoint(*wpt);
-              frac = distn / curdist;
-              wpt_new->SetCreationTime(frac * (wpt->creation_time.toTime_t() - time1) + time1);
-              wpt_new->shortname = QString();
-              wpt_new->description = QString();
-              linepart(lat1, lon1,
-                       wpt->latitude, wpt->longitude,
-                       frac,
-                       &wpt_new->latitude,
-                       &wpt_new->longitude);
-              if (altitude1 != unknown_alt && wpt->altitude != unknown_alt) {
-                wpt_new->altitude = altitude1 + frac * (wpt->altitude - altitude1);
-              }
-              if (opt_route) {
-                route_add_wpt(rte_new, wpt_new);
-              } else {
-                track_add_wpt(rte_new, wpt_new);
-              }
-            }
-          }
-        }
-      }
-      if (opt_route) {
-        route_add_wpt(rte_new, new Waypoint(*wpt));
-      } else {
-        track_add_wpt(rte_new, new Waypoint(*wpt));
-      }
-
-      lat1 = wpt->latitude;
-      lon1 = wpt->longitude;
-      altitude1 = wpt->altitude;
-      time1 = wpt->creation_time.toTime_t();
+      interpolate_wpt(wpt, rte_new);
+      add_wpt(rte_new, new Waypoint(*wpt));
     }
   }
   backuproute->flush();
   delete backuproute;
 }
 
+bool InterpolateFilter::stream_track(const route_head*)
+{
+  first = true;
+  stream_tracks = true;
+  return true;
+}
+
+bool InterpolateFilter::stream_point(Waypoint* wpt)
+{
+  if (!opt_route) {
+    interpolate_wpt(wpt, nullptr);
+  }
+  return true;
+}
+
+void InterpolateFilter::stream_finish()
+{
+  if (opt_route) {
+    process();
+  } else if (!stream_tracks) {
+    fatal(MYNAME ": Found no routes or tracks to operate on.\n");
+  }
+}
+
 void InterpolateFilter::init()
 {
+  lat1 = 0;
+  lon1 = 0;
+  altitude1 = unknown_alt;
+  time1 = 0;
+  stream_tracks = false;
 
   char* fm;
   if (opt_interval && opt_dist) {
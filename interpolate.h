@@ -36,6 +36,13 @@ public:
   }
   void init() override;
   void process() override;
+  bool stream_capable() override
+  {
+    return true;
+  }
+  bool stream_track(const route_head*) override;
+  bool stream_point(Waypoint* wpt) override;
+  void stream_finish() override;
 
 private:
   char* opt_interval = nullptr;
@@ -44,6 +51,14 @@ private:
   double dist = 0;
   char* opt_route = nullptr;
 
+  /* the point before */
+  double lat1 = 0;
+  double lon1 = 0;
+  double altitude1 = unknown_alt;
+  unsigned int time1 = 0;
+  bool first = true;
+  bool stream_tracks = false;
+
   arglist_t args[4] = {
     {
       "time", &opt_interval, "Time interval in seconds", nullptr,
@@ -62,6 +77,9 @@ private:
     ARG_TERMINATOR
   };
 
+  void add_wpt(route_head* rte, Waypoint* wpt);
+  void interpolate_wpt(const Waypoint* wpt, route_head* rte_new);
+
 };
 #endif // FILTERS_ENABLED
 #endif // INTERPOLATE_H_INCLUDED_
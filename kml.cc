@@ -26,8 +26,8 @@
 
 #include <cctype>                      // for tolower, toupper
 #include <cmath>                       // for fabs
-#include <cstdio>                      // for sscanf, printf
-#include <cstdlib>                     // for atoi, atol, atof
+#include <cstdio>                      // for printf
+#include <cstdlib>                     // for atoi, atol, atof, strtod
 #include <cstring>                     // for strcmp
 #include <tuple>                       // for tuple, make_tuple, tie
 
@@ -45,9 +45,10 @@
 #include <QtCore/QtGlobal>             // for foreach, qint64, qPrintable
 
 #include "defs.h"
-#include "grtcirc.h"                    // for RAD, gcdist, radtometers
+#include "grtcirc.h"                    // for RAD, gcdist, heading_true_degrees, radtometers
 #include "src/core/datetime.h"          // for DateTime
 #include "src/core/file.h"              // for File
+#include "src/core/numberformat.h"      // for appendFixed, formatFixed
 #include "src/core/optional.h"          // for optional
 #include "src/core/xmlstreamwriter.h"   // for XmlStreamWriter
 #include "src/core/xmltag.h"            // for xml_findfirst, xml_tag, fs_xml, xml_attribute, xml_findnext
@@ -70,6 +71,7 @@ static char* opt_labels = nullptr;
 static char* opt_max_position_points = nullptr;
 static char* opt_rotate_colors = nullptr;
 static char* opt_precision = nullptr;
+static char* opt_realtime_stream = nullptr;
 
 static int export_lines;
 static int export_points;
@@ -89,6 +91,22 @@ static int wpt_tmp_queued;
 static QString posnfilename;
 static QString posnfilenametmp;
 
+// State for the streaming realtime writer, see kml_wr_position_stream().
+static gpsbabel::File* kml_stream_file;
+static QString kml_stream_scratch;
+static bool kml_stream_view_warned;
+static qint64 kml_stream_view_pos;
+static qint64 kml_stream_trail_pos;
+static QByteArray kml_stream_foot;
+static route_head* kml_stream_trk;
+static bool kml_stream_carried;
+static Waypoint* kml_stream_newest;
+static computed_trkdata kml_stream_td;
+static int kml_stream_hrt_pts;
+static double kml_stream_hrt_tot;
+static int kml_stream_cad_pts;
+static double kml_stream_cad_tot;
+
 static route_head* gx_trk_head;
 static QList<gpsbabel::DateTime>* gx_trk_times;
 static QList<std::tuple<int, double, double, double>>* gx_trk_coords;
@@ -106,6 +124,7 @@ typedef enum  {
 } kml_point_type;
 
 static int realtime_positioning;
+static int realtime_stream;
 static bounds kml_bounds;
 static gpsbabel::DateTime kml_time_min;
 static gpsbabel::DateTime kml_time_max;
@@ -196,6 +215,11 @@ arglist_t kml_args[] = {
     "Precision of coordinates, number of decimals",
     DEFAULT_PRECISION, ARGTYPE_INT, ARG_NOMINMAX, nullptr
   },
+  {
+    "realtime_stream", &opt_realtime_stream,
+    "Write realtime positions incrementally (default = 0)",
+    "0", ARGTYPE_BOOL, ARG_NOMINMAX, nullptr
+  },
   ARG_TERMINATOR
 };
 
@@ -380,6 +404,42 @@ void wpt_ts_end(xg_string args, const QXmlStreamAttributes*)
   wpt_timespan_end = xml_parse_time(args);
 }
 
+/*
+ * Parse one "lon<sep>lat<sep>alt" tuple starting at *pp, returning the
+ * number of values converted.  On return *pp points just past the last
+ * value that was converted, so a run of tuples can be walked in a single
+ * pass without copying the remainder of the string.  This accepts the
+ * same input as sscanf("%lf,%lf,%lf") (or "%lf %lf %lf" when sep is a
+ * space) did.
+ */
+static int
+kml_parse_coord_tuple(const char** pp, double* lon, double* lat, double* alt, char sep)
+{
+  double* vals[3] = { lon, lat, alt };
+  const char* p = *pp;
+  int n = 0;
+
+  while (n < 3) {
+    const char* q = p;
+    if ((n > 0) && (sep != ' ')) {
+      if (*q != sep) {
+        break;
+      }
+      q++;
+    }
+    // strtod skips leading whitespace, just like %lf.
+    char* end;
+    double d = strtod(q, &end);
+    if (end == q) {
+      break;
+    }
+    *vals[n++] = d;
+    p = end;
+  }
+  *pp = p;
+  return n;
+}
+
 void wpt_coord(const QString& args, const QXmlStreamAttributes*)
 {
   double lat, lon, alt;
@@ -387,7 +447,9 @@ void wpt_coord(const QString& args, const QXmlStreamAttributes*)
     return;
   }
   // Alt is actually optional.
-  int n = sscanf(CSTRc(args), "%lf,%lf,%lf", &lon, &lat, &alt);
+  const QByteArray coords = args.toLatin1();
+  const char* p = coords.constData();
+  int n = kml_parse_coord_tuple(&p, &lon, &lat, &alt, ',');
   if (n >= 2) {
     wpt_tmp->latitude = lat;
     wpt_tmp->longitude = lon;
@@ -407,34 +469,32 @@ void wpt_icon(xg_string args, const QXmlStreamAttributes*)
 
 void trk_coord(xg_string args, const QXmlStreamAttributes*)
 {
-  int consumed = 0;
   double lat, lon, alt;
-  Waypoint* trkpt;
   int n = 0;
 
   route_head* trk_head = route_head_alloc();
 
-  QString iargs = args;
   if (wpt_tmp && !wpt_tmp->shortname.isEmpty()) {
     trk_head->rte_name  = wpt_tmp->shortname;
   }
   track_add_head(trk_head);
-  while ((n = sscanf(CSTRc(iargs), "%lf,%lf,%lf%n", &lon, &lat, &alt, &consumed)) > 0) {
-    trkpt = new Waypoint;
+
+  // Walk the tuples in place.  Rescanning a copy of the remainder of
+  // the string for every point is quadratic in the length of the
+  // LineString.
+  const QByteArray coords = args.toLatin1();
+  const char* p = coords.constData();
+  while ((n = kml_parse_coord_tuple(&p, &lon, &lat, &alt, ',')) >= 2) {
+    auto* trkpt = new Waypoint;
     trkpt->latitude = lat;
     trkpt->longitude = lon;
 
-    // Line malformed or two-arg format without alt .  Rescan.
-    if (2 == n) {
-      sscanf(CSTRc(iargs), "%lf,%lf%n", &lon, &lat, &consumed);
-    }
-
+    // Alt is optional.
     if (3 == n) {
       trkpt->altitude = alt;
     }
 
     track_add_wpt(trk_head, trkpt);
-    iargs = iargs.mid(consumed);
   }
 
   /* The track coordinates do not have a time associated with them. This is specified by using:
@@ -534,7 +594,9 @@ void gx_trk_coord(xg_string args, const QXmlStreamAttributes*)
   }
 
   double lat, lon, alt;
-  int n = sscanf(CSTR(args), "%lf %lf %lf", &lon, &lat, &alt);
+  const QByteArray coord = args.toUtf8();
+  const char* p = coord.constData();
+  int n = kml_parse_coord_tuple(&p, &lon, &lat, &alt, ' ');
   if (0 != n && 2 != n && 3 != n) {
     fatal(MYNAME ": coord field decode failure on \"%s\".\n", qPrintable(args));
   }
@@ -563,12 +625,9 @@ kml_rd_deinit()
 }
 
 static void
-kml_wr_init(const QString& fname)
+kml_wr_setunits()
 {
   char u = 's';
-  waypt_init_bounds(&kml_bounds);
-  kml_time_min = QDateTime();
-  kml_time_max = QDateTime();
 
   if (opt_units) {
     u = tolower(opt_units[0]);
@@ -591,6 +650,17 @@ kml_wr_init(const QString& fname)
     fatal("Units argument '%s' should be 's' for statute units, 'm' for metric, 'n' for nautical or 'a' for aviation.\n", opt_units);
     break;
   }
+}
+
+static void
+kml_wr_init(const QString& fname)
+{
+  waypt_init_bounds(&kml_bounds);
+  kml_time_min = QDateTime();
+  kml_time_max = QDateTime();
+
+  kml_wr_setunits();
+
   /*
    * Reduce race conditions with network read link.
    */
@@ -611,9 +681,20 @@ kml_wr_position_init(const QString& fname)
   posnfilename = fname;
   posnfilenametmp = QString("%1-").arg(fname);
   realtime_positioning = 1;
+  realtime_stream = (!! strcmp("0", opt_realtime_stream));
   max_position_points = atoi(opt_max_position_points);
 }
 
+static void
+kml_wr_position_replace()
+{
+  // QFile::rename() can't replace an existing file, so do a QFile::remove()
+  // first (which can fail silently if posnfilename doesn't exist). A race
+  // condition can theoretically still cause rename to fail... oh well.
+  QFile::remove(posnfilename);
+  QFile::rename(posnfilenametmp, posnfilename);
+}
+
 static void
 kml_wr_deinit()
 {
@@ -625,11 +706,7 @@ kml_wr_deinit()
   oqfile = nullptr;
 
   if (!posnfilenametmp.isEmpty()) {
-    // QFile::rename() can't replace an existing file, so do a QFile::remove()
-    // first (which can fail silently if posnfilename doesn't exist). A race
-    // condition can theoretically still cause rename to fail... oh well.
-    QFile::remove(posnfilename);
-    QFile::rename(posnfilenametmp, posnfilename);
+    kml_wr_position_replace();
   }
 }
 
@@ -639,6 +716,19 @@ kml_wr_position_deinit()
 //	kml_wr_deinit();
   posnfilename.clear();
   posnfilenametmp.clear();
+
+  if (kml_stream_file) {
+    kml_stream_file->close();
+    delete kml_stream_file;
+    kml_stream_file = nullptr;
+    QFile::remove(kml_stream_scratch);
+  }
+  kml_stream_scratch.clear();
+  kml_stream_foot.clear();
+  delete kml_stream_trk;
+  kml_stream_trk = nullptr;
+  delete kml_stream_newest;
+  kml_stream_newest = nullptr;
 }
 
 
@@ -895,21 +985,29 @@ int kml_altitude_known(const Waypoint* waypoint)
   return 1;
 }
 
-static
-void kml_write_coordinates(const Waypoint* waypointp)
+/*
+ * "lon,lat[,alt]" (or with another separator) built in a single buffer;
+ * this runs once per track point, so avoid the temporary QStrings.
+ */
+static QByteArray kml_coordinates(const Waypoint* waypointp, char sep)
 {
+  QByteArray coord;
+  coord.reserve(64);
+  gpsbabel::appendFixed(coord, waypointp->longitude, precision);
+  coord.append(sep);
+  gpsbabel::appendFixed(coord, waypointp->latitude, precision);
   if (kml_altitude_known(waypointp)) {
-    writer->writeTextElement(QStringLiteral("coordinates"),
-                             QString::number(waypointp->longitude, 'f', precision) + QString(",") +
-                             QString::number(waypointp->latitude, 'f', precision) + QString(",") +
-                             QString::number(waypointp->altitude, 'f', 2)
-                            );
-  } else {
-    writer->writeTextElement(QStringLiteral("coordinates"),
-                             QString::number(waypointp->longitude, 'f', precision) + QString(",") +
-                             QString::number(waypointp->latitude, 'f', precision)
-                            );
+    coord.append(sep);
+    gpsbabel::appendFixed(coord, waypointp->altitude, 2);
   }
+  return coord;
+}
+
+static
+void kml_write_coordinates(const Waypoint* waypointp)
+{
+  writer->writeTextElement(QStringLiteral("coordinates"),
+                           QString::fromLatin1(kml_coordinates(waypointp, ',')));
 }
 
 /* Rather than a default "top down" view, view from the side to highlight
@@ -918,8 +1016,8 @@ void kml_write_coordinates(const Waypoint* waypointp)
 static void kml_output_lookat(const Waypoint* waypointp)
 {
   writer->writeStartElement(QStringLiteral("LookAt"));
-  writer->writeTextElement(QStringLiteral("longitude"), QString::number(waypointp->longitude, 'f', precision));
-  writer->writeTextElement(QStringLiteral("latitude"), QString::number(waypointp->latitude, 'f', precision));
+  writer->writeTextElement(QStringLiteral("longitude"), gpsbabel::formatFixed(waypointp->longitude, precision));
+  writer->writeTextElement(QStringLiteral("latitude"), gpsbabel::formatFixed(waypointp->latitude, precision));
   writer->writeTextElement(QStringLiteral("tilt"), QStringLiteral("66"));
   writer->writeEndElement(); // Close LookAt tag
 }
@@ -998,7 +1096,7 @@ static void kml_output_description(const Waypoint* pt)
   /* This really shouldn't be here, but as of this writing,
    * Earth can't edit/display the TimeStamp.
    */
-  if (pt->GetCreationTime().isValid()) {
+  if (pt->creation_time.isValid()) {
     QString time_string = pt->CreationTimeXML();
     if (!time_string.isEmpty()) {
       kml_td(hwriter, QStringLiteral("Time: %1 ").arg(time_string));
@@ -1014,7 +1112,7 @@ static void kml_output_description(const Waypoint* pt)
 
 static void kml_recompute_time_bounds(const Waypoint* waypointp)
 {
-  if (waypointp->GetCreationTime().isValid()) {
+  if (waypointp->creation_time.isValid()) {
     if (!(kml_time_min.isValid()) ||
         (waypointp->GetCreationTime() < kml_time_min)) {
       kml_time_min = waypointp->GetCreationTime();
@@ -1150,16 +1248,7 @@ static void kml_output_tailer(const route_head* header)
         writer->writeStartElement(QStringLiteral("coordinates"));
         writer->writeCharacters(QStringLiteral("\n"));
       }
-      if (kml_altitude_known(tpt)) {
-        writer->writeCharacters(QString::number(tpt->longitude, 'f', precision) + QStringLiteral(",") +
-                                QString::number(tpt->latitude, 'f', precision) + QStringLiteral(",") +
-                                QString::number(tpt->altitude, 'f', 2) + QStringLiteral("\n")
-                               );
-      } else {
-        writer->writeCharacters(QString::number(tpt->longitude, 'f', precision) + QStringLiteral(",") +
-                                QString::number(tpt->latitude, 'f', precision) + QStringLiteral("\n")
-                               );
-      }
+      writer->writeCharacters(QString::fromLatin1(kml_coordinates(tpt, ',').append('\n')));
     }
     writer->writeEndElement(); // Close coordinates tag
     writer->writeEndElement(); // Close LineString tag
@@ -1539,7 +1628,7 @@ static void kml_geocache_pr(const Waypoint* waypointp)
   // Timestamp
   kml_output_timestamp(waypointp);
   QString date_placed;
-  if (waypointp->GetCreationTime().isValid()) {
+  if (waypointp->creation_time.isValid()) {
     date_placed = waypointp->GetCreationTime().toString("dd-MMM-yyyy");
   }
 
@@ -1753,7 +1842,7 @@ static int track_has_time(const route_head* header)
 {
   int points_with_time = 0;
   foreach (const Waypoint* tpt, header->waypoint_list) {
-    if (tpt->GetCreationTime().isValid()) {
+    if (tpt->creation_time.isValid()) {
       points_with_time++;
       if (points_with_time >= 2) {
         return 1;
@@ -1796,7 +1885,7 @@ static void kml_mt_hdr(const route_head* header)
   kml_output_positioning(false);
 
   foreach (const Waypoint* tpt, header->waypoint_list) {
-    if (tpt->GetCreationTime().isValid()) {
+    if (tpt->creation_time.isValid()) {
       QString time_string = tpt->CreationTimeXML();
       writer->writeOptionalTextElement(QStringLiteral("when"), time_string);
     } else {
@@ -1807,18 +1896,8 @@ static void kml_mt_hdr(const route_head* header)
 
   // TODO: How to handle clamped, floating, extruded, etc.?
   foreach (const Waypoint* tpt, header->waypoint_list) {
-    if (kml_altitude_known(tpt)) {
-      writer->writeTextElement(QStringLiteral("gx:coord"),
-                               QString::number(tpt->longitude, 'f', precision) + QString(" ") +
-                               QString::number(tpt->latitude, 'f', precision) + QString(" ") +
-                               QString::number(tpt->altitude, 'f', 2)
-                              );
-    } else {
-      writer->writeTextElement(QStringLiteral("gx:coord"),
-                               QString::number(tpt->longitude, 'f', precision) + QString(" ") +
-                               QString::number(tpt->latitude, 'f', precision)
-                              );
-    }
+    writer->writeTextElement(QStringLiteral("gx:coord"),
+                             QString::fromLatin1(kml_coordinates(tpt, ' ')));
 
     // Capture interesting traits to see if we need to do an ExtendedData
     // section later.
@@ -1937,17 +2016,20 @@ static void kml_write_AbstractView()
 // If our BB spans the antemeridian, flip sign on one.
 // This doesn't make our BB optimal, but it at least prevents us from
 // zooming to the wrong hemisphere.
-  if (kml_bounds.min_lon * kml_bounds.max_lon < 0) {
-    kml_bounds.min_lon = -kml_bounds.max_lon;
+// The streaming position writer keeps kml_bounds across fixes, so work
+// on a copy.
+  bounds bb = kml_bounds;
+  if (bb.min_lon * bb.max_lon < 0) {
+    bb.min_lon = -bb.max_lon;
   }
 
-  writer->writeTextElement(QStringLiteral("longitude"), QString::number((kml_bounds.min_lon + kml_bounds.max_lon) / 2, 'f', precision));
-  writer->writeTextElement(QStringLiteral("latitude"), QString::number((kml_bounds.min_lat + kml_bounds.max_lat) / 2, 'f', precision));
+  writer->writeTextElement(QStringLiteral("longitude"), QString::number((bb.min_lon + bb.max_lon) / 2, 'f', precision));
+  writer->writeTextElement(QStringLiteral("latitude"), QString::number((bb.min_lat + bb.max_lat) / 2, 'f', precision));
 
   // It turns out the length of the diagonal of the bounding box gives us a
   // reasonable guess for setting the camera altitude.
-  double bb_size = gcgeodist(kml_bounds.min_lat, kml_bounds.min_lon,
-                             kml_bounds.max_lat, kml_bounds.max_lon);
+  double bb_size = gcgeodist(bb.min_lat, bb.min_lon,
+                             bb.max_lat, bb.max_lon);
   // Clamp bottom zoom level.  Otherwise, a single point zooms to grass.
   if (bb_size < 1000) {
     bb_size = 1000;
@@ -1968,11 +2050,8 @@ void kml_mt_array_schema(const char* field_name, const char* display_name,
   writer->writeEndElement(); // Close gx:SimpleArrayField tag
 }
 
-static void kml_write()
+static void kml_parse_write_options()
 {
-  const global_trait* traits = get_traits();
-
-  // Parse options
   export_lines = (0 == strcmp("1", opt_export_lines));
   export_points = (0 == strcmp("1", opt_export_points));
   export_track = (0 ==  strcmp("1", opt_export_track));
@@ -1983,7 +2062,12 @@ static void kml_write()
   trackdirection = (!! strcmp("0", opt_trackdirection));
   line_width = atol(opt_line_width);
   precision = atol(opt_precision);
+}
 
+// Everything up to the view: the XML declaration, <kml> and the
+// Document's name.
+static void kml_write_head()
+{
   writer->writeStartDocument();
   // FIXME: This write of a blank line is needed for Qt 4.6 (as on Centos 6.3)
   // to include just enough whitespace between <xml/> and <gpx...> to pass
@@ -2009,15 +2093,16 @@ static void kml_write()
     writer->writeTextElement(QStringLiteral("snippet"), QStringLiteral("Created ") +
                              current_time().toString());
   }
+}
 
-  kml_write_AbstractView();
-
+static void kml_write_styles(bool have_routes, bool have_tracks)
+{
   // Style settings for bitmaps
-  if (route_waypt_count()) {
+  if (have_routes) {
     kml_write_bitmap_style(kmlpt_route, ICON_RTE, nullptr);
   }
 
-  if (track_waypt_count()) {
+  if (have_tracks) {
     if (trackdirection) {
       kml_write_bitmap_style(kmlpt_other, ICON_TRK, "track-none");
       for (int i = 0; i < 16; i++) {
@@ -2033,12 +2118,23 @@ static void kml_write()
 
   kml_write_bitmap_style(kmlpt_waypoint, ICON_WPT, nullptr);
 
-  if (track_waypt_count() || route_waypt_count()) {
+  if (have_tracks || have_routes) {
     writer->writeStartElement(QStringLiteral("Style"));
     writer->writeAttribute(QStringLiteral("id"), QStringLiteral("lineStyle"));
     kml_output_linestyle(opt_line_color, line_width);
     writer->writeEndElement(); // Close Style tag
   }
+}
+
+static void kml_write()
+{
+  const global_trait* traits = get_traits();
+
+  kml_parse_write_options();
+
+  kml_write_head();
+  kml_write_AbstractView();
+  kml_write_styles(route_waypt_count(), track_waypt_count());
 
   if (traits->trait_geocaches) {
     kml_gc_make_balloonstyle();
@@ -2139,19 +2235,11 @@ kml_get_posn_icon(int freshness)
 
 
 static route_head* posn_trk_head = nullptr;
+static gpsbabel::DateTime last_valid_fix;
 
 static void
-kml_wr_position(Waypoint* wpt)
+kml_wr_position_prepare(Waypoint* wpt)
 {
-  static gpsbabel::DateTime last_valid_fix;
-
-  kml_wr_init(posnfilenametmp);
-
-  if (!posn_trk_head) {
-    posn_trk_head = route_head_alloc();
-    track_add_head(posn_trk_head);
-  }
-
   if (!last_valid_fix.isValid()) {
     last_valid_fix = current_time();
   }
@@ -2175,13 +2263,332 @@ kml_wr_position(Waypoint* wpt)
     last_valid_fix = wpt->GetCreationTime();
   }
 
-  wpt->icon_descr = kml_get_posn_icon(wpt->GetCreationTime().toTime_t() - last_valid_fix.toTime_t());
+  wpt->icon_descr = kml_get_posn_icon(wpt->creation_time.toTime_t() - last_valid_fix.toTime_t());
+}
+
+/*
+ * The streaming writer keeps the output file open and only ever rewrites
+ * a bounded part of it.  The trail is cut into chunks of
+ * KML_STREAM_CHUNK points, each a Points folder and a Path placemark
+ * like the full writer's trail, the path of each chunk starting at the
+ * last point of the one before.  A full chunk is written once, for good.
+ * The open chunk, the live placemark and the end of the document follow
+ * it and are written again for every fix, as are the trail summary and
+ * the view, which sit in a fixed-size slot near the top of the file.
+ * With max_position_points the trail has to lose points at the front,
+ * so it isn't chunked but rewritten whole; it's bounded by that option.
+ * All of this happens in a scratch file next to the output, which is
+ * then copied and renamed over the output, so that a reader never sees
+ * a half written document.
+ */
+#define KML_STREAM_CHUNK 64
+#define KML_STREAM_VIEW_SLOT 4096
+
+static void
+kml_stream_capture_begin(QString* buf)
+{
+  writer = new gpsbabel::XmlStreamWriter(buf);
+  writer->setAutoFormatting(true);
+  writer->setAutoFormattingIndent(2);
+}
+
+static QByteArray
+kml_stream_capture_end(QString* buf)
+{
+  delete writer;
+  writer = nullptr;
+  if (!buf->endsWith('\n')) {
+    buf->append('\n');
+  }
+  return gpsbabel::XmlTextCodec::instance->fromUnicode(*buf);
+}
+
+static void
+kml_stream_init()
+{
+  kml_parse_write_options();
+  kml_wr_setunits();
+  waypt_init_bounds(&kml_bounds);
+  kml_time_min = QDateTime();
+  kml_time_max = QDateTime();
+
+  kml_stream_trk = route_head_alloc();
+  kml_stream_carried = false;
+  kml_stream_td = computed_trkdata();
+  kml_stream_hrt_pts = kml_stream_cad_pts = 0;
+  kml_stream_hrt_tot = kml_stream_cad_tot = 0.0;
+
+  // Write the document as the full writer would, with markers where the
+  // view and the trail go, and cut it there.
+  const QByteArray view_mark("<!--view-->");
+  const QByteArray trail_mark("<!--trail-->");
+  QString buf;
+  kml_stream_capture_begin(&buf);
+  writer->setAutoFormatting(false);
+  kml_write_head();
+  writer->writeComment(QStringLiteral("view"));
+  kml_write_styles(false, true);
+  writer->writeComment(QStringLiteral("trail"));
+  writer->writeEndElement(); // Close Document tag.
+  writer->writeEndElement(); // Close kml tag.
+  writer->writeEndDocument();
+  const QByteArray doc = kml_stream_capture_end(&buf);
+  const int view = doc.indexOf(view_mark);
+  const int styles = view + view_mark.size();
+  const int trail = doc.indexOf(trail_mark);
+  kml_stream_foot = doc.mid(trail + trail_mark.size());
+
+  kml_stream_scratch = QString("%1~").arg(posnfilename);
+  kml_stream_view_warned = false;
+  kml_stream_file = new gpsbabel::File(kml_stream_scratch);
+  kml_stream_file->open(QIODevice::WriteOnly | QIODevice::Truncate);
+  kml_stream_file->write(doc.left(view));
+  kml_stream_view_pos = kml_stream_file->pos();
+  kml_stream_file->write(QByteArray(KML_STREAM_VIEW_SLOT, ' '));
+  kml_stream_file->write(doc.mid(styles, trail - styles));
+  kml_stream_trail_pos = kml_stream_file->pos();
+}
+
+/*
+ * Add a trail point to the summary, as track_recompute() would have for
+ * the whole trail.  This sets the point's course and, if it has none,
+ * speed as well.
+ */
+static void
+kml_stream_summarize(Waypoint* wpt, const Waypoint* prev)
+{
+  computed_trkdata& td = kml_stream_td;
+  double lat1 = prev ? RAD(prev->latitude) : 0;
+  double lon1 = prev ? RAD(prev->longitude) : 0;
+  double lat2 = RAD(wpt->latitude);
+  double lon2 = RAD(wpt->longitude);
+
+  WAYPT_SET(wpt, course, heading_true_degrees(lat1, lon1, lat2, lon2));
+  double dist_m = radtometers(gcdist(lat1, lon1, lat2, lon2));
+  if (lat1 && lon1) {
+    td.distance_meters += dist_m;
+  }
+
+  if (!WAYPT_HAS(wpt, speed) && (dist_m > 1) && prev &&
+      wpt->creation_time.isValid() && prev->creation_time.isValid() &&
+      (wpt->creation_time.toMSecsSinceEpoch() > prev->creation_time.toMSecsSinceEpoch())) {
+    WAYPT_SET(wpt, speed, dist_m / (prev->creation_time.msecsTo(wpt->creation_time) / 1000.0));
+  }
+  if (WAYPT_HAS(wpt, speed)) {
+    if (!td.min_spd || (wpt->speed < td.min_spd)) {
+      td.min_spd = wpt->speed;
+    }
+    if (!td.max_spd || (wpt->speed > td.max_spd)) {
+      td.max_spd = wpt->speed;
+    }
+  }
+
+  if (wpt->altitude != unknown_alt) {
+    if (!td.min_alt || (wpt->altitude < td.min_alt)) {
+      td.min_alt = wpt->altitude;
+    }
+    if (!td.max_alt || (wpt->altitude > td.max_alt)) {
+      td.max_alt = wpt->altitude;
+    }
+  }
+
+  if (wpt->heartrate > 0) {
+    kml_stream_hrt_tot += wpt->heartrate;
+    td.avg_hrt = kml_stream_hrt_tot / ++kml_stream_hrt_pts;
+    if (!td.min_hrt || (wpt->heartrate < td.min_hrt)) {
+      td.min_hrt = wpt->heartrate;
+    }
+    if (!td.max_hrt || (wpt->heartrate > td.max_hrt)) {
+      td.max_hrt = wpt->heartrate;
+    }
+  }
+
+  if (wpt->cadence > 0) {
+    kml_stream_cad_tot += wpt->cadence;
+    td.avg_cad = kml_stream_cad_tot / ++kml_stream_cad_pts;
+    if (!td.max_cad || (wpt->cadence > td.max_cad)) {
+      td.max_cad = wpt->cadence;
+    }
+  }
+
+  if (wpt->creation_time.isValid()) {
+    qint64 t = wpt->creation_time.toMSecsSinceEpoch();
+    if (!td.start.isValid() || (t < td.start.toMSecsSinceEpoch())) {
+      td.start = wpt->GetCreationTime();
+    }
+    if (!td.end.isValid() || (t > td.end.toMSecsSinceEpoch())) {
+      td.end = wpt->GetCreationTime();
+    }
+  }
+}
+
+/*
+ * The trail points in kml_stream_trk as one chunk.  A point carried over
+ * from the chunk before only starts the path, its placemark is written.
+ */
+static void
+kml_stream_write_trail()
+{
+  const route_head* trk = kml_stream_trk;
+  if ((trk->rte_waypt_ct == 0) || (kml_stream_carried && (trk->rte_waypt_ct == 1))) {
+    return;
+  }
+
+  kml_output_header(trk, nullptr);
+  foreach (const Waypoint* tpt, trk->waypoint_list) {
+    if (!kml_stream_carried || (tpt != trk->waypoint_list.front())) {
+      kml_track_disp(tpt);
+    }
+  }
+  kml_init_color_sequencer(1);
+  kml_output_tailer(trk);
+}
 
+static void
+kml_stream_add_trail_point(const Waypoint* wpt)
+{
+  auto tpt = new Waypoint(*wpt);
+  tpt->wpt_flags.new_trkseg = (kml_stream_trk->rte_waypt_ct == 0);
+  kml_stream_summarize(tpt, kml_stream_newest);
+  kml_stream_trk->waypoint_list.waypt_add(tpt);
+  kml_stream_trk->rte_waypt_ct++;
+
+  delete kml_stream_newest;
+  kml_stream_newest = new Waypoint(*tpt);
+}
+
+// Remove all but the last count points from the front of the trail.
+static void
+kml_stream_drop_trail(int count)
+{
+  WaypointList& list = kml_stream_trk->waypoint_list;
+  int drop = kml_stream_trk->rte_waypt_ct - count;
+  for (auto it = list.begin(); (drop > 0) && (it != list.end()); ++it, --drop) {
+    (*it)->wpt_flags.marked_for_deletion = 1;
+  }
+  kml_stream_trk->rte_waypt_ct -= list.waypt_del_marked();
+  if (kml_stream_trk->rte_waypt_ct > 0) {
+    list.front()->wpt_flags.new_trkseg = 1;
+  }
+}
+
+/*
+ * The trail summary and the view.  Should they outgrow their slot, the
+ * summary is left out.
+ */
+static QByteArray
+kml_stream_view()
+{
+  QString buf;
+  kml_stream_capture_begin(&buf);
+  if ((export_lines || export_points) && !kml_stream_view_warned) {
+    kml_output_trkdescription(kml_stream_trk, &kml_stream_td);
+  }
+  kml_write_AbstractView();
+  QByteArray view = kml_stream_capture_end(&buf);
+  if ((view.size() > KML_STREAM_VIEW_SLOT) && !kml_stream_view_warned) {
+    warning(MYNAME ": The trail summary no longer fits into the stream, leaving it out.\n");
+    kml_stream_view_warned = true;
+    view = kml_stream_view();
+  }
+  return view;
+}
+
+/*
+ * Publish the scratch file the way the full writer publishes its
+ * output, by renaming a complete copy over it.
+ */
+static void
+kml_stream_publish()
+{
+  kml_stream_file->flush();
+  QFile::remove(posnfilenametmp);
+  if (QFile::copy(kml_stream_scratch, posnfilenametmp)) {
+    kml_wr_position_replace();
+  }
+}
+
+static void
+kml_wr_position_stream(Waypoint* wpt)
+{
+  if (kml_stream_file == nullptr) {
+    kml_stream_init();
+  }
+
+  kml_wr_position_prepare(wpt);
+
+  /* As in the full writer, only extend the trail once we've moved. */
+  if (!kml_stream_newest ||
+      radtometers(gcdist(RAD(wpt->latitude), RAD(wpt->longitude),
+                         RAD(kml_stream_newest->latitude), RAD(kml_stream_newest->longitude))) > 50) {
+    kml_stream_add_trail_point(wpt);
+  } else {
+    wpt->latitude = kml_stream_newest->latitude;
+    wpt->longitude = kml_stream_newest->longitude;
+  }
+  kml_add_to_bounds(wpt);
+
+  /* Without the summary the view is a few hundred bytes; should it grow
+     past the slot anyway, the previous one stays. */
+  const QByteArray view = kml_stream_view();
+  if (view.size() <= KML_STREAM_VIEW_SLOT) {
+    kml_stream_file->seek(kml_stream_view_pos);
+    kml_stream_file->write(view.leftJustified(KML_STREAM_VIEW_SLOT, ' '));
+  }
+
+  QString buf;
+  /* A full chunk is written for good, its last point starts the next. */
+  if (!max_position_points && (kml_stream_trk->rte_waypt_ct > KML_STREAM_CHUNK)) {
+    kml_stream_capture_begin(&buf);
+    kml_stream_write_trail();
+    const QByteArray chunk = kml_stream_capture_end(&buf);
+    kml_stream_file->seek(kml_stream_trail_pos);
+    kml_stream_file->write(chunk);
+    kml_stream_trail_pos = kml_stream_file->pos();
+    kml_stream_drop_trail(1);
+    kml_stream_carried = true;
+  }
+
+  buf.clear();
+  kml_stream_capture_begin(&buf);
+  kml_stream_write_trail();
+  kml_waypt_pr(wpt);
+  const QByteArray tail = kml_stream_capture_end(&buf);
+
+  kml_stream_file->seek(kml_stream_trail_pos);
+  kml_stream_file->write(tail);
+  kml_stream_file->write(kml_stream_foot);
+  kml_stream_file->resize(kml_stream_file->pos());
+  kml_stream_publish();
+
+  if (max_position_points && (kml_stream_trk->rte_waypt_ct >= max_position_points)) {
+    kml_stream_drop_trail(max_position_points - 1);
+  }
+}
+
+static void
+kml_wr_position(Waypoint* wpt)
+{
+  if (realtime_stream) {
+    kml_wr_position_stream(wpt);
+    return;
+  }
+
+  kml_wr_init(posnfilenametmp);
+
+  if (!posn_trk_head) {
+    posn_trk_head = route_head_alloc();
+    track_add_head(posn_trk_head);
+  }
+
+  kml_wr_position_prepare(wpt);
 
   /* In order to avoid clutter while we're sitting still, don't add
      track points if we've not moved a minimum distance from the
      beginning of our accumulated track. */
-  {
+  if (posn_trk_head->waypoint_list.empty()) {
+    track_add_wpt(posn_trk_head, new Waypoint(*wpt));
+  } else {
     Waypoint* newest_posn= posn_trk_head->waypoint_list.back();
 
     if (radtometers(gcdist(RAD(wpt->latitude), RAD(wpt->longitude),
@@ -2248,7 +2248,7 @@ lowranceusr4_trail_disp(const Waypoint* wpt)
   gbfputc(0, file_out);
 
   /* Timestamp */
-  gbfputint32(wpt->GetCreationTime().toTime_t(), file_out);
+  gbfputint32(wpt->creation_time.toTime_t(), file_out);
 
   /* Long/Lat */
   gbfputdbl(wpt->longitude * DEGREESTORADIANS, file_out);
@@ -1420,7 +1420,7 @@ void mag_track_disp(const Waypoint* waypointp)
   double ilon = waypointp->longitude;
   struct tm* tm = nullptr;
   if (waypointp->creation_time.isValid()) {
-    const time_t ct = waypointp->GetCreationTime().toTime_t();
+    const time_t ct = waypointp->creation_time.toTime_t();
     tm = gmtime(&ct);
     if (tm) {
       hms = tm->tm_hour * 10000 + tm->tm_min  * 100 +
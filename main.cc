@@ -28,7 +28,10 @@
 #include <QtCore/QChar>             // for QChar
 #include <QtCore/QCoreApplication>  // for QCoreApplication
 #include <QtCore/QFile>             // for QFile
+#include <QtCore/QFileInfo>         // for QFileInfo
 #include <QtCore/QIODevice>         // for QIODevice::ReadOnly
+#include <QtCore/QLatin1String>     // for QLatin1String
+#include <QtCore/QList>             // for QList
 #include <QtCore/QLocale>           // for QLocale
 #include <QtCore/QStack>            // for QStack
 #include <QtCore/QString>           // for QString
@@ -37,14 +40,14 @@
 #include <QtCore/QTextCodec>        // for QTextCodec
 #include <QtCore/QTextStream>       // for QTextStream
 #include <QtCore/QtConfig>          // for QT_VERSION_STR
-#include <QtCore/QtGlobal>          // for qPrintable, qVersion, QT_VERSION, QT_VERSION_CHECK
+#include <QtCore/QtGlobal>          // for qPrintable, qVersion, qAsConst, QT_VERSION, QT_VERSION_CHECK
 
 #ifdef AFL_INPUT_FUZZING
 #include "argv-fuzz-inl.h"
 #endif
 
 #include "defs.h"
-#include "cet_util.h"               // for cet_convert_init, cet_convert_strings, cet_convert_deinit, cet_deregister, cet_register, cet_cs_vec_utf8
+#include "cet_util.h"               // for cet_convert_init, cet_convert_strings, cet_convert_deinit, cet_deregister, cet_find_cs_by_name, cet_register, cet_cs_vec_utf8
 #include "csv_util.h"               // for csv_linesplit
 #include "filter.h"                 // for Filter
 #include "filterdefs.h"             // for disp_filter_vec, disp_filter_vecs, disp_filters, exit_filter_vecs, find_filter_vec, free_filter_vec, init_filter_vecs
@@ -200,6 +203,172 @@ signal_handler(int sig)
   tracking_status.request_terminate = 1;
 }
 
+/*
+ * Read one input file (-f).
+ */
+static void
+read_input(ff_vecs_t* ivecs, const QString& fname)
+{
+  cet_convert_init(ivecs->encode, ivecs->fixed_encode);	/* init by module vec */
+
+  start_session(ivecs->name, fname);
+  ivecs->rd_init(fname);
+  ivecs->read();
+  ivecs->rd_deinit();
+
+  cet_convert_strings(global_opts.charset, nullptr, nullptr);
+  cet_convert_deinit();
+}
+
+/*
+ * Write everything read so far to one output file (-F).
+ */
+static void
+write_output(ff_vecs_t* ovecs, const QString& ofname)
+{
+  cet_convert_init(ovecs->encode, ovecs->fixed_encode);
+
+  ovecs->wr_init(ofname);
+
+  if (global_opts.charset != &cet_cs_vec_utf8) {
+    /*
+     * Push and pop verbose_status so
+     * we don't get dual progress bars
+     * when doing characterset
+     * transformation.
+     */
+    int saved_status = global_opts.verbose_status;
+    global_opts.verbose_status = 0;
+    cet_convert_strings(nullptr, global_opts.charset, nullptr);
+    global_opts.verbose_status = saved_status;
+  }
+
+  ovecs->write();
+  ovecs->wr_deinit();
+
+  cet_convert_deinit();
+
+  /* put back any format specific strings converted for this output */
+  cet_restore_strings();
+}
+
+/*
+ * Run one filter (-x) over everything read so far.
+ */
+static void
+run_filter(Filter* filter)
+{
+  filter->init();
+  filter->process();
+  filter->deinit();
+  free_filter_vec(filter);
+}
+
+/*
+ * Do the arguments after a -f, from argn on, only name filters and then a
+ * single output with a format other than the input's?  Then that -f can
+ * be streamed: nothing in between changes how the file is read.
+ */
+static bool
+stream_cmdline(const QStringList& qargs, int argn, const QString& iname)
+{
+  QStringList fnames;
+
+  for (; argn < qargs.size(); argn++) {
+    if ((qargs.at(argn).size() < 2) || (qargs.at(argn).at(0).toLatin1() != '-')) {
+      return false;
+    }
+    char c = qargs.at(argn).at(1).toLatin1();
+    QString optarg = FETCH_OPTARG;
+    QString name = optarg.section(',', 0, 0);
+
+    switch (c) {
+    case 'x':
+      /* filters keep their options in a single instance */
+      if (name.isEmpty() || fnames.contains(name, Qt::CaseInsensitive)) {
+        return false;
+      }
+      fnames.append(name);
+      break;
+    case 'o':
+      /* -o would reset the options of the input's format before it is read */
+      if (name.isEmpty() || (name.compare(iname, Qt::CaseInsensitive) == 0)) {
+        return false;
+      }
+      /* followed by the -F, and nothing else */
+      if ((++argn >= qargs.size()) || !qargs.at(argn).startsWith(QLatin1String("-F"))) {
+        return false;
+      }
+      optarg = FETCH_OPTARG;
+      return !optarg.isEmpty() && (argn + 1 == qargs.size());
+    default:
+      return false;
+    }
+  }
+  return false;
+}
+
+/*
+ * Convert one file without holding all of its trackpoints in memory, when
+ * both formats and all filters support it (see stream_ops_t and Filter).
+ * The trackpoints go through the filters into the writer as the reader
+ * lets go of them; everything else is filtered and written as usual once
+ * the input has been read.  The filters are freed.
+ * Returns false without having touched anything when the conversion has
+ * to take the usual path.
+ */
+static bool
+stream_convert(ff_vecs_t* ivecs, const QString& fname, const QList<Filter*>& filters,
+               ff_vecs_t* ovecs, const QString& ofname)
+{
+  if ((ivecs == ovecs) || (ivecs->stream_ops.rd_capable == nullptr) ||
+      (ovecs->stream_ops.wr_begin == nullptr) || (ovecs->wr_init == nullptr) ||
+      (global_opts.masked_objective & POSNDATAMASK) || !QFileInfo(fname).isFile() ||
+      (waypt_count() != 0) || (route_count() != 0) || (track_count() != 0)) {
+    return false;
+  }
+  /* the writer gets the points as read, so it has to take UTF-8 */
+  if ((cet_find_cs_by_name(ovecs->encode) != &cet_cs_vec_utf8) ||
+      !ivecs->stream_ops.rd_capable()) {
+    return false;
+  }
+  for (auto* filter : filters) {
+    if (!filter->stream_capable()) {
+      return false;
+    }
+  }
+
+  const stream_ops_t& ops = ovecs->stream_ops;
+
+  cet_convert_init(ivecs->encode, ivecs->fixed_encode);
+
+  for (auto* filter : filters) {
+    filter->init();
+  }
+
+  start_session(ivecs->name, fname);
+  ops.wr_begin();
+  /* the points go out unconverted, see stream_ops_t */
+  track_stream_begin(ops.wr_trk_hdr, ops.wr_trk_tlr, ops.wr_trk_wpt, filters);
+  ivecs->rd_init(fname);
+  ivecs->read();
+  ivecs->rd_deinit();
+  track_stream_end();
+
+  cet_convert_strings(global_opts.charset, nullptr, nullptr);
+  cet_convert_deinit();
+
+  for (auto* filter : filters) {
+    filter->stream_finish();
+    filter->deinit();
+    free_filter_vec(filter);
+  }
+
+  write_output(ovecs, ofname);
+
+  return true;
+}
+
 static int
 run(const char* prog_name)
 {
@@ -215,11 +384,10 @@ run(const char* prog_name)
   const char* fvec_opts = nullptr;
   int opt_version = 0;
   bool did_something = false;
-  WaypointList* wpt_head_bak;
-  RouteList* rte_head_bak;
-  RouteList* trk_head_bak;
-  bool lists_backedup;
   QStack<QargStackElement> qargs_stack;
+  /* a -f to be streamed into the -F, and the filters in between */
+  QString stream_fname;
+  QList<Filter*> stream_filters;
 
   // Use QCoreApplication::arguments() to process the command line.
   QStringList qargs = QCoreApplication::arguments();
@@ -307,15 +475,12 @@ run(const char* prog_name)
         global_opts.masked_objective |= WPTDATAMASK;
       }
 
-      cet_convert_init(ivecs->encode, ivecs->fixed_encode);	/* init by module vec */
-
-      start_session(ivecs->name, fname);
-      ivecs->rd_init(fname);
-      ivecs->read();
-      ivecs->rd_deinit();
-
-      cet_convert_strings(global_opts.charset, nullptr, nullptr);
-      cet_convert_deinit();
+      if ((ivecs->stream_ops.rd_capable != nullptr) && qargs_stack.isEmpty() &&
+          stream_cmdline(qargs, argn + 1, ivecs->name)) {
+        stream_fname = fname;
+      } else {
+        read_input(ivecs, fname);
+      }
 
       did_something = true;
       break;
@@ -334,46 +499,17 @@ run(const char* prog_name)
           fatal("Format does not support writing.\n");
         }
 
-        cet_convert_init(ovecs->encode, ovecs->fixed_encode);
-
-        lists_backedup = false;
-        wpt_head_bak = nullptr;
-        rte_head_bak = nullptr;
-        trk_head_bak = nullptr;
-
-        ovecs->wr_init(ofname);
-
-        if (global_opts.charset != &cet_cs_vec_utf8) {
-          /*
-           * Push and pop verbose_status so
-                          		 * we don't get dual progress bars
-           * when doing characterset
-           * transformation.
-           */
-          int saved_status = global_opts.verbose_status;
-          global_opts.verbose_status = 0;
-          lists_backedup = true;
-          waypt_backup(&wpt_head_bak);
-          route_backup(&rte_head_bak);
-          track_backup(&trk_head_bak);
-
-          cet_convert_strings(nullptr, global_opts.charset, nullptr);
-          global_opts.verbose_status = saved_status;
-        }
-
-        ovecs->write();
-        ovecs->wr_deinit();
-
-        cet_convert_deinit();
-
-        if (lists_backedup) {
-          waypt_restore(wpt_head_bak);
-          delete wpt_head_bak;
-          route_restore(rte_head_bak);
-          delete rte_head_bak;
-          track_restore(trk_head_bak);
-          delete trk_head_bak;
+        if (stream_fname.isEmpty()) {
+          write_output(ovecs, ofname);
+        } else if (!stream_convert(ivecs, stream_fname, stream_filters, ovecs, ofname)) {
+          read_input(ivecs, stream_fname);
+          for (auto* f : qAsConst(stream_filters)) {
+            run_filter(f);
+          }
+          write_output(ovecs, ofname);
         }
+        stream_fname.clear();
+        stream_filters.clear();
       }
       break;
     case 's':
@@ -414,10 +550,11 @@ run(const char* prog_name)
       filter = find_filter_vec(CSTR(optarg), &fvec_opts);
 
       if (filter) {
-        filter->init();
-        filter->process();
-        filter->deinit();
-        free_filter_vec(filter);
+        if (stream_fname.isEmpty()) {
+          run_filter(filter);
+        } else {
+          stream_filters.append(filter);
+        }
       }  else {
         fatal("Unknown filter '%s'\n",qPrintable(optarg));
       }
@@ -529,32 +666,37 @@ run(const char* prog_name)
       global_opts.masked_objective |= WPTDATAMASK;
     }
 
-    cet_convert_init(ivecs->encode, 1);
+    if ((qargs.size() == 2) && ovecs && (ivecs->rd_init != nullptr) &&
+        stream_convert(ivecs, qargs.at(0), QList<Filter*>(), ovecs, qargs.at(1))) {
+      /* read and written in one go */
+    } else {
+      cet_convert_init(ivecs->encode, 1);
 
-    start_session(ivecs->name, qargs.at(0));
-    if (ivecs->rd_init == nullptr) {
-      fatal("Format does not support reading.\n");
-    }
-    ivecs->rd_init(qargs.at(0));
-    ivecs->read();
-    ivecs->rd_deinit();
+      start_session(ivecs->name, qargs.at(0));
+      if (ivecs->rd_init == nullptr) {
+        fatal("Format does not support reading.\n");
+      }
+      ivecs->rd_init(qargs.at(0));
+      ivecs->read();
+      ivecs->rd_deinit();
 
-    cet_convert_strings(global_opts.charset, nullptr, nullptr);
-    cet_convert_deinit();
+      cet_convert_strings(global_opts.charset, nullptr, nullptr);
+      cet_convert_deinit();
 
-    if (qargs.size() == 2 && ovecs) {
-      cet_convert_init(ovecs->encode, 1);
-      cet_convert_strings(nullptr, global_opts.charset, nullptr);
+      if (qargs.size() == 2 && ovecs) {
+        cet_convert_init(ovecs->encode, 1);
+        cet_convert_strings(nullptr, global_opts.charset, nullptr);
 
-      if (ovecs->wr_init == nullptr) {
-        fatal("Format does not support writing.\n");
-      }
+        if (ovecs->wr_init == nullptr) {
+          fatal("Format does not support writing.\n");
+        }
 
-      ovecs->wr_init(qargs.at(1));
-      ovecs->write();
-      ovecs->wr_deinit();
+        ovecs->wr_init(qargs.at(1));
+        ovecs->write();
+        ovecs->wr_deinit();
 
-      cet_convert_deinit();
+        cet_convert_deinit();
+      }
     }
   } else if (!qargs.isEmpty()) {
     usage(prog_name,0);
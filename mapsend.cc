@@ -459,7 +459,7 @@ static void mapsend_track_disp(const Waypoint* wpt)
    *
    * This is rumoured (but yet unconfirmed) to be fixed in f/w 5.12.
    */
-  int32_t t = wpt->GetCreationTime().toTime_t();
+  int32_t t = wpt->creation_time.toTime_t();
   if (t < last_time)  {
     t = last_time;
   }
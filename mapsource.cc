@@ -1114,7 +1114,7 @@ mps_routehdr_w(gbfile* mps_file, int mps_ver, const route_head* rte)
   if (true) {
     foreach (const Waypoint* testwpt, rte->waypoint_list) {
       if (rte_datapoints == 0) {
-        uniqueValue = testwpt->GetCreationTime().toTime_t();
+        uniqueValue = testwpt->creation_time.toTime_t();
       }
       if (testwpt->latitude > maxlat) {
         maxlat = testwpt->latitude;
@@ -1539,7 +1539,7 @@ mps_trackhdr_w(gbfile* mps_file, int mps_ver, const route_head* trk)
   if (true) {
     foreach (const Waypoint* testwpt, trk->waypoint_list) {
       if (trk_datapoints == 0) {
-        uniqueValue = testwpt->GetCreationTime().toTime_t();
+        uniqueValue = testwpt->creation_time.toTime_t();
       }
       trk_datapoints++;
     }
@@ -1593,7 +1593,7 @@ mps_trackhdr_w_wrapper(const route_head* trk)
 static void
 mps_trackdatapoint_w(gbfile* mps_file, int mps_ver, const Waypoint* wpt)
 {
-  time_t	t = wpt->GetCreationTime().toTime_t();
+  time_t	t = wpt->creation_time.toTime_t();
   char zbuf[10];
 
   double	mps_altitude = wpt->altitude;
@@ -23,9 +23,9 @@
 #include <cstdio>           // for sprintf, size_t
 #include <cstring>          // for strlen, memmove, strchr, strcpy, strncmp, strcat, strncpy
 
-#include <QtCore/QList>     // for QList
+#include <QtCore/QByteArray> // for QByteArray
+#include <QtCore/QHash>     // for QHash
 #include <QtCore/QString>   // for QString
-#include <QtCore/QtGlobal>  // for foreach
 
 #include "defs.h"
 #include "cet.h"            // for cet_utf8_strdup, cet_utf8_strlen, cet_utf8_strndup
@@ -39,25 +39,13 @@ static const char vowels[] = "aeiouAEIOU";
 static constexpr unsigned int default_target_len = 8U;
 static const char* DEFAULT_BADCHARS = "\"$.,'!-";
 
-/*
- * Hash table tunings.   The reality is that our hash doesn't have to be
- * terribly complex; our strings are short (typically 8-20 bytes) and the
- * string hash mixes things up enough that strcmp can generally bail on the
- * first byte or two for a mismatch.
- */
-static constexpr unsigned int prime = 37U;
-
-struct uniq_shortname {
-  char* orig_shortname{nullptr};
-  int conflictctr{0};
-};
-
 struct  mkshort_handle_imp {
   unsigned int target_len{default_target_len};
   char* badchars{nullptr};
   char* goodchars{nullptr};
   char* defname{nullptr};
-  QList<uniq_shortname*> namelist[prime];
+  /* Names handed out so far, upper cased, with their conflict counters. */
+  QHash<QByteArray, int> namelist;
 
   /* Various internal flags */
   bool mustupper{false};
@@ -84,19 +72,6 @@ static struct replacements {
   {nullptr, 		nullptr}
 };
 
-/*
- * We hash all strings as upper case.
- */
-unsigned int hash_string(const char* key)
-{
-  unsigned int hash = 0;
-  while (*key) {
-    hash = ((hash<<5) ^ (hash>>27)) ^ toupper(*key++);
-  }
-  hash = hash % prime;
-  return hash;
-}
-
 short_handle
 mkshort_new_handle()
 {
@@ -109,43 +84,34 @@ mkshort_new_handle()
   return h;
 }
 
+/*
+ * Names are compared as case_ignore_strcmp() on the bytes used to,
+ * ignoring the case of ASCII letters only, so key the table on the
+ * name with those upper cased.
+ */
 static
-uniq_shortname*
-is_unique(mkshort_handle_imp* h, char* name)
+QByteArray
+mkshort_key(const char* name)
 {
-
-  int hash = hash_string(name);
-  foreach (uniq_shortname* z, h->namelist[hash]) {
-    if (0 == case_ignore_strcmp(z->orig_shortname, name)) {
-      return z;
+  QByteArray key(name);
+  for (char& c : key) {
+    if ((c >= 'a') && (c <= 'z')) {
+      c = c - 'a' + 'A';
     }
   }
-  return (uniq_shortname*) nullptr;
-}
-
-static
-void
-add_to_hashlist(mkshort_handle_imp* h, char* name)
-{
-  int hash = hash_string(name);
-  uniq_shortname* s = (uniq_shortname*) xcalloc(1, sizeof(uniq_shortname));
-
-  s->orig_shortname = xstrdup(name);
-  h->namelist[hash].append(s);
+  return key;
 }
 
 char*
 mkshort_add_to_list(mkshort_handle_imp* h, char* name)
 {
-  uniq_shortname* s;
+  QHash<QByteArray, int>::iterator s;
 
-  while ((s = is_unique(h, name))) {
+  while ((s = h->namelist.find(mkshort_key(name))) != h->namelist.end()) {
     char tbuf[13];
     size_t l = strlen(name);
 
-    s->conflictctr++;
-
-    int dl = sprintf(tbuf, ".%d", s->conflictctr);
+    int dl = sprintf(tbuf, ".%d", ++s.value());
 
     if (l + dl < h->target_len) {
       name = (char*) xrealloc(name, l + dl + 1);
@@ -155,7 +121,7 @@ mkshort_add_to_list(mkshort_handle_imp* h, char* name)
     }
   }
 
-  add_to_hashlist(h, name);
+  h->namelist.insert(mkshort_key(name), 0);
   return name;
 }
 
@@ -168,19 +134,14 @@ mkshort_del_handle(short_handle* h)
     return;
   }
 
-  for (auto &i : hdr->namelist) {
-    while (!i.isEmpty()) {
 #if 0
-      if (global_opts.verbose_status >= 2 && s->conflictctr) {
-        fprintf(stderr, "%d Output name conflicts: '%s'\n",
-                s->conflictctr, s->orig_shortname);
-      }
-#endif
-      auto s = i.takeFirst();
-      xfree(s->orig_shortname);
-      xfree(s);
+  for (auto s = hdr->namelist.cbegin(); s != hdr->namelist.cend(); ++s) {
+    if (global_opts.verbose_status >= 2 && s.value()) {
+      fprintf(stderr, "%d Output name conflicts: '%s'\n",
+              s.value(), s.key().constData());
     }
   }
+#endif
   /* setshort_badchars(*h, NULL); ! currently setshort_badchars() always allocates something ! */
   if (hdr->badchars != nullptr) {
     xfree(hdr->badchars);
@@ -1198,7 +1198,7 @@ mmo_write_wpt_cb(const Waypoint* wpt)
   QString str;
   int icon = 0;
 
-  time_t time = wpt->GetCreationTime().toTime_t();
+  time_t time = wpt->creation_time.toTime_t();
   if (time < 0) {
     time = 0;
   }
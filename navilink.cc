@@ -420,7 +420,7 @@ encode_waypoint(const Waypoint* waypt, unsigned char* buffer)
   buffer[10] = 0;
   buffer[11] = 0;
   encode_position(waypt, buffer + 12);
-  encode_datetime(waypt->GetCreationTime().toTime_t(), buffer + 22);
+  encode_datetime(waypt->creation_time.toTime_t(), buffer + 22);
   buffer[28] = find_icon_from_descr(waypt->icon_descr);
   buffer[29] = 0;
   buffer[30] = 0x00;
@@ -455,7 +455,7 @@ encode_trackpoint(const Waypoint* waypt, unsigned serial, unsigned char* buffer)
   le_write32(buffer + 4, x);
   le_write32(buffer + 8, y);
   encode_position(waypt, buffer + 12);
-  encode_datetime(waypt->GetCreationTime().toTime_t(), buffer + 22);
+  encode_datetime(waypt->creation_time.toTime_t(), buffer + 22);
   buffer[28] = z;
   buffer[29] = MPS_TO_KPH(WAYPT_GET(waypt, speed, 0) / 2);
   buffer[30] = 0x5a;
@@ -20,21 +20,20 @@
 
  */
 
-#include <cctype>                  // for isprint
+#include <cctype>                  // for isprint, isspace
+#include <cerrno>                  // for errno
+#include <climits>                 // for INT_MAX, INT_MIN
 #include <cmath>                   // for fabs, lround
 #include <cstdio>                  // for snprintf, sscanf, NULL, fprintf, fputc, stderr
-#include <cstdlib>                 // for atoi, atof
-#include <cstring>                 // for strncmp, memset, strlen, strchr, strstr, strrchr
+#include <cstdlib>                 // for atoi, atof, strtod, strtol
+#include <cstring>                 // for strncmp, memset, strlen, strchr, strstr, strrchr, memchr, strnlen
 #include <ctime>                   // for gmtime
 #include <iterator>                // for operator!=, reverse_iterator
 
 #include <QtCore/QByteArray>       // for QByteArray
-#include <QtCore/QChar>            // for QChar, operator==, operator!=
-#include <QtCore/QCharRef>         // for QCharRef
 #include <QtCore/QDateTime>        // for QDateTime
 #include <QtCore/QList>            // for QList
-#include <QtCore/QString>          // for QString, QString::KeepEmptyParts
-#include <QtCore/QStringList>      // for QStringList
+#include <QtCore/QString>          // for QString
 #include <QtCore/QThread>          // for QThread
 #include <QtCore/QTime>            // for QTime
 #include <QtCore/QtGlobal>         // for qPrintable
@@ -250,6 +249,138 @@ nmea_cksum(const char* const buf)
   return x;
 }
 
+/*
+ * A sentence split at its commas.  The fields point into the caller's
+ * buffer, nothing is copied, so the buffer has to outlive the split.
+ * As with QString::split() the last field runs to the end of the
+ * sentence and keeps any trailing "*hh" checksum.
+ *
+ * The conversions follow QString::toDouble() and QString::toInt():
+ * blanks around the number are allowed, anything else in the field
+ * makes it zero, and so does an empty or missing field.
+ */
+class NmeaFields
+{
+public:
+  NmeaFields(const char* begin, const char* end)
+  {
+    const char* p = begin;
+    while (true) {
+      const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+      const char* fend = comma ? comma : end;
+      if (count < kMaxFields) {
+        str[count] = p;
+        len[count] = fend - p;
+        count++;
+      }
+      if (comma == nullptr) {
+        break;
+      }
+      p = comma + 1;
+    }
+  }
+
+  explicit NmeaFields(const char* sentence) :
+    NmeaFields(sentence, sentence + strlen(sentence)) {}
+
+  int size() const
+  {
+    return count;
+  }
+
+  bool isEmpty(int i) const
+  {
+    return i >= count || len[i] == 0;
+  }
+
+  /* First character of the field, NUL if it is empty. */
+  char at0(int i) const
+  {
+    return isEmpty(i) ? '\0' : str[i][0];
+  }
+
+  void chop(int i, int n)
+  {
+    if (i < count) {
+      len[i] = (len[i] > n) ? len[i] - n : 0;
+    }
+  }
+
+  QString toString(int i) const
+  {
+    return isEmpty(i) ? QString() : QString::fromUtf8(str[i], len[i]);
+  }
+
+  double toDouble(int i) const
+  {
+    const char* s;
+    const char* e;
+    if (!trimmed(i, &s, &e)) {
+      return 0;
+    }
+    char* end;
+    double d = strtod(s, &end);
+    return (end == e) ? d : 0;
+  }
+
+  int toInt(int i) const
+  {
+    const char* s;
+    const char* e;
+    if (!trimmed(i, &s, &e)) {
+      return 0;
+    }
+    errno = 0;
+    char* end;
+    long l = strtol(s, &end, 10);
+    if ((end != e) || errno || (l < INT_MIN) || (l > INT_MAX)) {
+      return 0;
+    }
+    return l;
+  }
+
+  /* sscanf("%d") style: the leading number, trailing junk is ignored. */
+  int leadingInt(int i) const
+  {
+    return isEmpty(i) ? 0 : strtol(str[i], nullptr, 10);
+  }
+
+  /* sscanf("%lf") style: the leading number, trailing junk is ignored. */
+  double leadingDouble(int i) const
+  {
+    return isEmpty(i) ? 0 : strtod(str[i], nullptr);
+  }
+
+private:
+  static constexpr int kMaxFields = 32;
+
+  bool trimmed(int i, const char** s, const char** e) const
+  {
+    if (isEmpty(i)) {
+      return false;
+    }
+    const char* b = str[i];
+    const char* t = b + len[i];
+    while ((b < t) && isspace(static_cast<unsigned char>(*b))) {
+      b++;
+    }
+    while ((t > b) && isspace(static_cast<unsigned char>(t[-1]))) {
+      t--;
+    }
+    /* strtod() would take hex, QString::toDouble() doesn't. */
+    if ((b == t) || memchr(b, 'x', t - b) || memchr(b, 'X', t - b)) {
+      return false;
+    }
+    *s = b;
+    *e = t;
+    return true;
+  }
+
+  const char* str[kMaxFields];
+  int len[kMaxFields];
+  int count{0};
+};
+
 static void
 nmea_add_base_wpt(Waypoint* wpt, route_head* trk)
 {
@@ -286,6 +417,13 @@ nmea_release_wpt(NmeaWaypoint* wpt)
   }
 }
 
+static bool
+nmea_rd_stream_capable()
+{
+  /* getposn reads a single position from a serial port */
+  return getposnarg == nullptr;
+}
+
 static void
 nmea_rd_init(const QString& fname)
 {
@@ -404,27 +542,31 @@ nmea_set_waypoint_time(Waypoint* wpt, struct tm* time, double fsec)
 }
 
 static void
-gpgll_parse(char* ibuf)
+gpgll_parse(const char* ibuf)
 {
+  if ((posn_type == gpgga) || (posn_type == gprmc)) {
+    return;
+  }
+
   if (trk_head == nullptr) {
     trk_head = route_head_alloc();
     track_add_head(trk_head);
   }
 
-  QStringList fields = QString(ibuf).split(",", QString::KeepEmptyParts);
+  NmeaFields fields(ibuf);
 
   double latdeg = 0;
-  if (fields.size() > 1) latdeg = fields[1].toDouble();
-  QChar latdir = 'N';
-  if (fields.size() > 2) latdir = fields[2][0];
+  if (fields.size() > 1) latdeg = fields.toDouble(1);
+  char latdir = 'N';
+  if (fields.size() > 2) latdir = fields.at0(2);
   double lngdeg = 0;
-  if (fields.size() > 3) lngdeg = fields[3].toDouble();
-  QChar lngdir = 'E';
-  if (fields.size() > 4) lngdir = fields[4][0];
+  if (fields.size() > 3) lngdeg = fields.toDouble(3);
+  char lngdir = 'E';
+  if (fields.size() > 4) lngdir = fields.at0(4);
   double hmsd = 0;
-  if (fields.size() > 5) hmsd = fields[5].toDouble();
+  if (fields.size() > 5) hmsd = fields.toDouble(5);
   bool valid = false;
-  if (fields.size() > 6) valid = fields[6].startsWith('A');
+  if (fields.size() > 6) valid = (fields.at0(6) == 'A');
 
   if (!valid) {
     return;
@@ -459,38 +601,40 @@ gpgll_parse(char* ibuf)
 }
 
 static void
-gpgga_parse(char* ibuf)
+gpgga_parse(const char* ibuf)
 {
+  posn_type = gpgga;
+
   if (trk_head == nullptr) {
     trk_head = route_head_alloc();
     track_add_head(trk_head);
   }
 
-  QStringList fields = QString(ibuf).split(",", QString::KeepEmptyParts);
+  NmeaFields fields(ibuf);
   double hms = 0;
-  if (fields.size() > 1) hms = fields[1].toDouble();
+  if (fields.size() > 1) hms = fields.toDouble(1);
   double latdeg = 0;
-  if (fields.size() > 2) latdeg = fields[2].toDouble();
-  QChar latdir = 'N';
-  if (fields.size() > 3) latdir = fields[3][0];
+  if (fields.size() > 2) latdeg = fields.toDouble(2);
+  char latdir = 'N';
+  if (fields.size() > 3) latdir = fields.at0(3);
   double lngdeg = 0;
-  if (fields.size() > 4) lngdeg = fields[4].toDouble();
-  QChar lngdir = 'W';
-  if (fields.size() > 5) lngdir = fields[5][0];
+  if (fields.size() > 4) lngdeg = fields.toDouble(4);
+  char lngdir = 'W';
+  if (fields.size() > 5) lngdir = fields.at0(5);
   int fix = fix_unknown;
-  if (fields.size() > 6) fix = fields[6].toInt();
+  if (fields.size() > 6) fix = fields.toInt(6);
   int nsats = 0;
-  if (fields.size() > 7) nsats = fields[7].toInt();
+  if (fields.size() > 7) nsats = fields.toInt(7);
   double hdop = 0;
-  if (fields.size() > 8) hdop = fields[8].toDouble();
+  if (fields.size() > 8) hdop = fields.toDouble(8);
   double alt = unknown_alt;
-  if (fields.size() > 9) alt = fields[9].toDouble();
-  QChar altunits ='M';
-  if (fields.size() > 10) altunits = fields[10][0];
+  if (fields.size() > 9) alt = fields.toDouble(9);
+  char altunits ='M';
+  if (fields.size() > 10) altunits = fields.at0(10);
   double geoidheight = unknown_alt;
-  if (fields.size() > 11) geoidheight = fields[11].toDouble();
-  QChar geoidheightunits = 'M';
-  if (fields.size() > 12) geoidheightunits = fields[12][0];
+  if (fields.size() > 11) geoidheight = fields.toDouble(11);
+  char geoidheightunits = 'M';
+  if (fields.size() > 12) geoidheightunits = fields.at0(12);
 
   /*
    * In serial mode, allow the fix with an invalid position through
@@ -553,32 +697,40 @@ gpgga_parse(char* ibuf)
 }
 
 static void
-gprmc_parse(char* ibuf)
+gprmc_parse(const char* ibuf)
 {
+  /*
+   * Always parse RMC because like ZDA it contains the full date,
+   * even when GGA provides the positions.
+   */
+  if (posn_type != gpgga) {
+    posn_type = gprmc;
+  }
+
   if (trk_head == nullptr) {
     trk_head = route_head_alloc();
     track_add_head(trk_head);
   }
 
-  QStringList fields = QString(ibuf).split(",", QString::KeepEmptyParts);
+  NmeaFields fields(ibuf);
   double hms = 0;
-  if (fields.size() > 1) hms = fields[1].toDouble();
-  QChar fix = 'V'; // V == "Invalid"
-  if (fields.size() > 2) fix = fields[2][0];
+  if (fields.size() > 1) hms = fields.toDouble(1);
+  char fix = 'V'; // V == "Invalid"
+  if (fields.size() > 2) fix = fields.at0(2);
   double latdeg = 0;
-  if (fields.size() > 3) latdeg = fields[3].toDouble();
-  QChar latdir = 'N';
-  if (fields.size() > 4) latdir = fields[4][0];
+  if (fields.size() > 3) latdeg = fields.toDouble(3);
+  char latdir = 'N';
+  if (fields.size() > 4) latdir = fields.at0(4);
   double lngdeg = 0;
-  if (fields.size() > 5) lngdeg = fields[5].toDouble();
-  QChar lngdir = 'W';
-  if (fields.size() > 6) lngdir = fields[6][0];
+  if (fields.size() > 5) lngdeg = fields.toDouble(5);
+  char lngdir = 'W';
+  if (fields.size() > 6) lngdir = fields.at0(6);
   double speed = 0;
-  if (fields.size() > 7) speed = fields[7].toDouble();
+  if (fields.size() > 7) speed = fields.toDouble(7);
   double course = 0;
-  if (fields.size() > 8) course = fields[8].toDouble();
+  if (fields.size() > 8) course = fields.toDouble(8);
   int dmy = 0;
-  if (fields.size() > 9) dmy = fields[9].toDouble();
+  if (fields.size() > 9) dmy = fields.toDouble(9);
 
   if (fix != 'A') {
     /* ignore this fix - it is invalid */
@@ -649,24 +801,24 @@ gprmc_parse(char* ibuf)
 }
 
 static void
-gpwpl_parse(char* ibuf)
+gpwpl_parse(const char* ibuf)
 {
   // The last field isn't actually separated by a field separator and
   // is a string, so we brutally whack the checksum (trailing *NN).
-  QString qibuf = QString(ibuf);
-  qibuf.truncate(qibuf.lastIndexOf('*'));
-  QStringList fields = qibuf.split(",", QString::KeepEmptyParts);
+  // Without a checksum there is nothing left of the sentence.
+  const char* ck = strrchr(ibuf, '*');
+  NmeaFields fields(ibuf, ck ? ck : ibuf);
 
   double latdeg = 0;
-  if (fields.size() > 1) latdeg = fields[1].toDouble();
-  QChar latdir = 'N';
-  if (fields.size() > 2) latdir = fields[2][0];
+  if (fields.size() > 1) latdeg = fields.toDouble(1);
+  char latdir = 'N';
+  if (fields.size() > 2) latdir = fields.at0(2);
   double lngdeg = 0;
-  if (fields.size() > 3) lngdeg = fields[3].toDouble();
-  QChar lngdir = 'E';
-  if (fields.size() > 4) lngdir = fields[4][0];
+  if (fields.size() > 3) lngdeg = fields.toDouble(3);
+  char lngdir = 'E';
+  if (fields.size() > 4) lngdir = fields.at0(4);
   QString sname;
-  if (fields.size() > 5) sname = fields[5];
+  if (fields.size() > 5) sname = fields.toString(5);
 
   if (latdir == 'S') {
     latdeg = -latdeg;
@@ -685,13 +837,14 @@ gpwpl_parse(char* ibuf)
 }
 
 static void
-gpzda_parse(char* ibuf)
+gpzda_parse(const char* ibuf)
 {
-  double hms;
-  int dd, mm, yy, lclhrs, lclmins;
+  NmeaFields fields(ibuf);
+  double hms = fields.leadingDouble(1);
+  int dd = fields.leadingInt(2);
+  int mm = fields.leadingInt(3);
+  int yy = fields.leadingInt(4);
 
-  sscanf(ibuf,"$%*2cZDA,%lf,%d,%d,%d,%d,%d",
-         &hms, &dd, &mm, &yy, &lclhrs, &lclmins);
   tm.tm_sec  = (int) hms % 100;
   tm.tm_min  = (((int) hms - tm.tm_sec) / 100) % 100;
   tm.tm_hour = (int) hms / 10000;
@@ -707,36 +860,36 @@ gpzda_parse(char* ibuf)
 // a QString::split() to make it more tolerant of really empty fields from
 // certain GPS implementations, but didn't replace the (somewhat funky) back
 // half to match the parse. There are definitely some readability issues
-// here.
+// here. The split is now done by NmeaFields, which doesn't copy the fields.
 // The numbering as per http://aprs.gids.nl/nmea/#gsa was the reference as
 // the field numbers conveniently match our index.
 static void
-gpgsa_parse(char* ibuf)
+gpgsa_parse(const char* ibuf)
 {
   int  prn[12] = {0};
   memset(prn,0xff,sizeof(prn));
 
-  QStringList fields = QString(ibuf).split(",", QString::KeepEmptyParts);
+  NmeaFields fields(ibuf);
   int nfields = fields.size();
   // 0 = "GPGSA"
   // 1 = Mode. Ignored
-  QChar fix;
+  char fix = '\0';
   if (nfields > 1) {
-    fix = fields[2][0];
+    fix = fields.at0(2);
   }
 
   // 12 fields, index 3 through 14. 
   for (int cnt = 0; cnt <= 11; cnt++) {
-    if (nfields > cnt + 3) prn[cnt] = fields[cnt + 3].toInt();
+    if (nfields > cnt + 3) prn[cnt] = fields.toInt(cnt + 3);
   }
 
   float pdop = 0, hdop = 0, vdop = 0;
-  if (nfields > 14) pdop = fields[15].toDouble();
-  if (nfields > 15) hdop = fields[16].toDouble();
+  if (nfields > 14) pdop = fields.toDouble(15);
+  if (nfields > 15) hdop = fields.toDouble(16);
   if (nfields > 16) {
      // Last one is special. The checksum isn't split out above.
-    fields[17].chop(3);
-    vdop = fields[17].toDouble();
+    fields.chop(17, 3);
+    vdop = fields.toDouble(17);
   }
 
   if (curr_waypt) {
@@ -762,15 +915,15 @@ gpgsa_parse(char* ibuf)
 }
 
 static void
-gpvtg_parse(char* ibuf)
+gpvtg_parse(const char* ibuf)
 {
-  QStringList fields = QString(ibuf).split(",", QString::KeepEmptyParts);
+  NmeaFields fields(ibuf);
   double course = 0;
-  if (fields.size() > 1) course = fields[1].toDouble();
+  if (fields.size() > 1) course = fields.toDouble(1);
   double speed_n = 0;
-  if (fields.size() > 5) speed_n = fields[5].toDouble();
+  if (fields.size() > 5) speed_n = fields.toDouble(5);
   double speed_k = 0;
-  if (fields.size() > 7) speed_k = fields[7].toDouble();
+  if (fields.size() > 7) speed_k = fields.toDouble(7);
 
   if (curr_waypt) {
     WAYPT_SET(curr_waypt, course, course);
@@ -796,7 +949,7 @@ double pcmpt_deg(int d)
 }
 
 static void
-pcmpt_parse(char* ibuf)
+pcmpt_parse(const char* ibuf)
 {
   int i, j1, j2, j3, j4, j5, j6;
   int lat, lon;
@@ -807,9 +960,18 @@ pcmpt_parse(char* ibuf)
 
   dmy = hms = 0;
 
-  sscanf(ibuf,"$PCMPT,%d,%d,%d,%c,%f,%d,%19[^,],%d,%f,%d,%f,%c,%d,%c,%d",
+  /* @@@ zmarties: The scan assumes all fields are present, but the NMEA
+     format allows any field to be missed out if there is no data for
+     that field, so we first substitute a default value of zero for any
+     missing field.
+  */
+  char* filled = strstr(ibuf, ",,") ? gstrsub(ibuf, ",,", ",0,") : nullptr;
+
+  sscanf(filled ? filled : ibuf,
+         "$PCMPT,%d,%d,%d,%c,%f,%d,%19[^,],%d,%f,%d,%f,%c,%d,%c,%d",
          &j1, &j2, &j3, &altflag, &alt, &j4, (char*) &coords,
          &j5, &f1, &j6, &f2, &u1, &dmy, &u2, &hms);
+  xfree(filled);
 
   if (altflag == 'D' && curr_waypt && alt > 0) {
     curr_waypt->altitude =  alt /*+ 500*/;
@@ -920,23 +1082,48 @@ nmea_fix_timestamps(route_head* track)
           wpt->creation_time+=SECONDS_PER_DAY;
         }
       }
-      prev = wpt->GetCreationTime().toTime_t();
+      prev = wpt->creation_time.toTime_t();
     }
   }
 }
 
-static int
-notalkerid_strmatch(const char * s1, const char *sentenceFormatterMnemonicCode)
-{
 /*
- * compare leading start of parametric sentence character ('$'), sentence address field, and trailing comma
- * to the desired sentence formatter mnemonic code (the 3rd-5th characters of the sentence address field).
- * The talker identifier mnemonic(the 1st-2nd characters of the sentence address field)
- * is likely "GP" for Global Positioning System (GPS)
- * but other talkers like "IN" for Integrated Navigation can emit relevant sentences,
- * so we ignore the talker identifier mnemonic.
+ * Sentences we understand, by sentence formatter mnemonic code (the
+ * 3rd-5th characters of the sentence address field).
+ * The talker identifier mnemonic (the 1st-2nd characters of the sentence
+ * address field) is likely "GP" for Global Positioning System (GPS)
+ * but other talkers like "IN" for Integrated Navigation can emit relevant
+ * sentences, so we ignore the talker identifier mnemonic.
  */
-return strncmp(s1,"$",1) || strncmp(s1+3,sentenceFormatterMnemonicCode,3) || strncmp(s1+6,",",1);
+struct nmea_sentence_t {
+  const char* formatter;
+  char** enable;        /* option that has to be set, if any */
+  void (*parse)(const char* ibuf);
+};
+
+static const nmea_sentence_t nmea_sentences[] = {
+  { "WPL", nullptr,    gpwpl_parse },
+  { "GGA", &opt_gpgga, gpgga_parse },
+  { "RMC", &opt_gprmc, gprmc_parse },
+  { "GLL", nullptr,    gpgll_parse },
+  { "ZDA", nullptr,    gpzda_parse },
+  { "VTG", &opt_gpvtg, gpvtg_parse },   /* speed and course */
+  { "GSA", &opt_gpgsa, gpgsa_parse },   /* GPS fix */
+};
+
+static int
+nmea_hexdigit(char c)
+{
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0';
+  }
+  if ((c >= 'A') && (c <= 'F')) {
+    return c - 'A' + 10;
+  }
+  if ((c >= 'a') && (c <= 'f')) {
+    return c - 'a' + 10;
+  }
+  return -1;
 }
 
 static void
@@ -962,9 +1149,12 @@ nmea_parse_one_line(char* ibuf)
     int ckval = nmea_cksum(&tbuf[1]);
     *ck = '*';
     ck++;
-    int ckcmp;
-    sscanf(ck, "%2X", &ckcmp);
-    if (ckval != ckcmp) {
+    int ckcmp = 0;
+    int ndigits = 0;
+    for (int d; (ndigits < 2) && ((d = nmea_hexdigit(ck[ndigits])) >= 0); ndigits++) {
+      ckcmp = (ckcmp << 4) | d;
+    }
+    if ((ndigits == 0) || (ckval != ckcmp)) {
       Warning() << "Invalid NMEA checksum. Computed " << ckval << " but found " << ckcmp << ". Ignoring sentence";
       return;
     }
@@ -977,54 +1167,29 @@ nmea_parse_one_line(char* ibuf)
     return;
   }
 
-  if (strstr(tbuf+1,"$")!=nullptr) {
+  if (strchr(tbuf+1, '$') != nullptr) {
     /* If line has more than one $, there is probably an error in it. */
     return;
   }
 
-  /* @@@ zmarties: The parse routines all assume all fields are present, but
-     the NMEA format allows any field to be missed out if there is no data
-     for that field.  Rather than change all the parse routines, we first
-     substitute a default value of zero for any missing field.
-  */
-  if (strstr(tbuf, ",,")) {
-    tbuf = gstrsub(tbuf, ",,", ",0,");
-  }
-
-  if (0 == notalkerid_strmatch(tbuf, "WPL")) {
-    gpwpl_parse(tbuf);
-  } else if (opt_gpgga && (0 == notalkerid_strmatch(tbuf, "GGA"))) {
-    posn_type = gpgga;
-    gpgga_parse(tbuf);
-  } else if (opt_gprmc && (0 == notalkerid_strmatch(tbuf, "RMC"))) {
-    if (posn_type != gpgga) {
-      posn_type = gprmc;
-    }
-    /*
-     * Always call gprmc_parse() because like GPZDA
-     * it contains the full date.
-     */
-    gprmc_parse(tbuf);
-  } else if (0 == notalkerid_strmatch(tbuf, "GLL")) {
-    if ((posn_type != gpgga) && (posn_type != gprmc)) {
-      gpgll_parse(tbuf);
+  /* The parsers split the sentence in place and read a missing (empty)
+     field as zero, so the line doesn't have to be rewritten first. */
+  if ((strnlen(tbuf, 7) == 7) && (tbuf[6] == ',')) {
+    for (const auto& sentence : nmea_sentences) {
+      if (0 == strncmp(tbuf + 3, sentence.formatter, 3)) {
+        if ((sentence.enable == nullptr) || *sentence.enable) {
+          sentence.parse(tbuf);
+        }
+        return;
+      }
     }
-  } else if (0 == notalkerid_strmatch(tbuf, "ZDA")) {
-    gpzda_parse(tbuf);
-  } else if (0 == strncmp(tbuf, "$PCMPT,", 7)) {
+  }
+
+  if (0 == strncmp(tbuf, "$PCMPT,", 7)) {
     pcmpt_parse(tbuf);
-  } else if (opt_gpvtg && (0 == notalkerid_strmatch(tbuf, "VTG"))) {
-    gpvtg_parse(tbuf); /* speed and course */
-  } else if (opt_gpgsa && (0 == notalkerid_strmatch(tbuf, "GSA"))) {
-    gpgsa_parse(tbuf); /* GPS fix */
   } else if (0 == strncmp(tbuf, "$ADPMB,5,0", 10)) {
     amod_waypoint = 1;
   }
-
-  if (tbuf != ibuf) {
-    /* clear up the dynamic buffer we used because substitution was required */
-    xfree(tbuf);
-  }
 }
 
 static void
@@ -1099,6 +1264,18 @@ nmea_read()
       }
       lt = last_read_time;
     }
+
+    /*
+     * When streaming, everything but the last point of the track is
+     * final once all points have a date: only curr_waypt (at most the
+     * last one) is still updated, and nmea_fix_timestamps() has nothing
+     * to do.  PCMPT points may be in two lists at once, so hold on to
+     * everything while any of those are around.
+     */
+    if (track_stream_open() && trk_head && (without_date == 0) &&
+        (tm.tm_year != 0) && pcmpt_head.isEmpty() && (track_count() == 1)) {
+      track_stream_release(trk_head, trk_head->waypoint_list.count() - 1);
+    }
   }
 
   /* try to complete date-less trackpoints */
@@ -1275,19 +1452,19 @@ nmea_trackpt_pr(const Waypoint* wpt)
       if (sleepus >= 0) {
         QThread::usleep(sleepus);
       } else {
-        long wait_time = wpt->GetCreationTime().toTime_t() - last_time;
+        long wait_time = wpt->creation_time.toTime_t() - last_time;
         if (wait_time > 0) {
           QThread::usleep(wait_time * 1000000);
         }
       }
     }
-    last_time = wpt->GetCreationTime().toTime_t();
+    last_time = wpt->creation_time.toTime_t();
   }
 
   double lat = degrees2ddmm(wpt->latitude);
   double lon = degrees2ddmm(wpt->longitude);
 
-  time_t ct = wpt->GetCreationTime().toTime_t();
+  time_t ct = wpt->creation_time.toTime_t();
   struct tm* tm = gmtime(&ct);
   if (tm) {
     hms = tm->tm_hour * 10000 + tm->tm_min * 100 + tm->tm_sec;
@@ -1425,7 +1602,11 @@ ff_vecs_t nmea_vecs = {
     nmea_rd_posn_init, nmea_rd_posn, nmea_rd_deinit,
     nmea_wr_posn_init, nmea_wr_posn, nmea_wr_posn_deinit
   },
-  nullptr
+  nullptr,
+  {
+    nmea_rd_stream_capable,
+    nullptr, nullptr, nullptr, nullptr
+  }
 };
 
 /*
@@ -24,14 +24,19 @@
 #include "defs.h"
 #include "xmlgeneric.h"
 #include <QtCore/QHash>
+#include <QtCore/QVector>
 #include <QtCore/QXmlStreamAttributes>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 
-static char* opt_tag, *opt_tagnd, *created_by;
+static char* opt_tag, *opt_tagnd, *created_by, *opt_tagged;
 
 static arglist_t osm_args[] = {
   { "tag", &opt_tag, 	"Write additional way tag key/value pairs", nullptr, ARGTYPE_STRING, ARG_NOMINMAX, nullptr},
   { "tagnd", &opt_tagnd,	"Write additional node tag key/value pairs", nullptr, ARGTYPE_STRING, ARG_NOMINMAX, nullptr },
   { "created_by", &created_by, "Use this value as custom created_by value","GPSBabel", ARGTYPE_STRING, ARG_NOMINMAX, nullptr },
+  { "tagged", &opt_tagged, "Only read nodes with tags as waypoints", nullptr, ARGTYPE_BOOL, ARG_NOMINMAX, nullptr },
   ARG_TERMINATOR
 };
 
@@ -39,6 +44,32 @@ static arglist_t osm_args[] = {
 
 static QHash<QString, const Waypoint*> waypoints;
 
+/*
+ * Reader side node stores, flat arrays sorted by the integer osm id and
+ * binary searched.  Files list nodes by ascending id, so they're almost
+ * always appended.  Nodes that become waypoints are kept as pointers;
+ * with the "tagged" option plain nodes (no tags) only matter as way
+ * vertices, so all we keep for them is their position, in the 1e-7
+ * degree units osm uses itself, and time: 24 bytes a node.
+ */
+struct osm_node_ref {
+  qint64 id;
+  const Waypoint* wpt;
+};
+struct osm_plain_node {
+  qint64 id;
+  int32_t latitude;
+  int32_t longitude;
+  gpsbabel::PackedDateTime creation_time;
+};
+static QVector<osm_node_ref> nodes;
+static QVector<osm_plain_node> plain_nodes;
+static qint64 cur_node_id;
+static double cur_node_lat;
+static double cur_node_lon;
+static gpsbabel::DateTime cur_node_time;
+static bool cur_node_valid;
+
 static QHash<QString, int> keys;
 static QHash<QString, const struct osm_icon_mapping_s*> values;
 static QHash<QString, const struct osm_icon_mapping_s*> icons;
@@ -472,16 +503,71 @@ osm_strip_html(const QString& str)
 }
 
 
+template <typename T>
+static typename QVector<T>::const_iterator
+osm_lower_bound(const QVector<T>& list, qint64 id)
+{
+  return std::lower_bound(list.cbegin(), list.cend(), id,
+  [](const T& node, qint64 key) {
+    return node.id < key;
+  });
+}
+
+template <typename T>
+static const T*
+osm_find_node(const QVector<T>& list, qint64 id)
+{
+  if (list.isEmpty() || (list.last().id < id)) {
+    return nullptr;
+  }
+  auto it = osm_lower_bound(list, id);
+  return ((it != list.cend()) && (it->id == id)) ? &*it : nullptr;
+}
+
+template <typename T>
+static void
+osm_add_node(QVector<T>& list, const T& node)
+{
+  if (list.isEmpty() || (list.last().id < node.id)) {
+    list.append(node);
+  } else {
+    list.insert(osm_lower_bound(list, node.id) - list.cbegin(), node);
+  }
+}
+
+static Waypoint*
+osm_node_wpt(qint64 id, double lat, double lon, const gpsbabel::DateTime& time)
+{
+  auto* wpt = new Waypoint;
+  wpt->description = "osm-id " + QString::number(id);
+  wpt->latitude = lat;
+  wpt->longitude = lon;
+  wpt->creation_time = time;
+  wpt->wpt_flags.fmt_use = 1;
+  return wpt;
+}
+
 static void
 osm_node_end(xg_string, const QXmlStreamAttributes*)
 {
+  if (!cur_node_valid) {
+    delete wpt;
+    wpt = nullptr;
+    return;
+  }
+
+  /* Without "tagged", every node is a waypoint. */
+  if ((wpt == nullptr) && !opt_tagged) {
+    wpt = osm_node_wpt(cur_node_id, cur_node_lat, cur_node_lon, cur_node_time);
+  }
   if (wpt) {
-    if (wpt->wpt_flags.fmt_use) {
-      waypt_add(wpt);
-    } else {
-      delete wpt;
-    }
+    osm_add_node(nodes, osm_node_ref{cur_node_id, wpt});
+    waypt_add(wpt);
     wpt = nullptr;
+  } else {
+    osm_add_node(plain_nodes, osm_plain_node{cur_node_id,
+                 int32_t(lround(cur_node_lat * 1e7)), int32_t(lround(cur_node_lon * 1e7)),
+                 cur_node_time});
   }
 }
 
@@ -489,32 +575,38 @@ osm_node_end(xg_string, const QXmlStreamAttributes*)
 static void
 osm_node(xg_string, const QXmlStreamAttributes* attrv)
 {
-  wpt = new Waypoint;
+  cur_node_lat = cur_node_lon = 0;
+  cur_node_time = gpsbabel::DateTime();
+  cur_node_valid = false;
 
   if (attrv->hasAttribute("id")) {
-    QString atstr = attrv->value("id").toString();
-    wpt->description =  "osm-id " + atstr;
-    if (waypoints.contains(atstr)) {
-      warning(MYNAME ": Duplicate osm-id %s!\n", qPrintable(atstr));
+    QStringRef atstr = attrv->value("id");
+    bool ok;
+    cur_node_id = atstr.toLongLong(&ok);
+    if (!ok) {
+      warning(MYNAME ": Invalid osm-id %s!\n", qPrintable(atstr.toString()));
+    } else if (osm_find_node(nodes, cur_node_id) || osm_find_node(plain_nodes, cur_node_id)) {
+      warning(MYNAME ": Duplicate osm-id %s!\n", qPrintable(atstr.toString()));
     } else {
-      waypoints.insert(atstr, wpt);
-      wpt->wpt_flags.fmt_use = 1;
+      cur_node_valid = true;
     }
   }
 
   // if (attrv->hasAttribute("user")) ; // ignored
 
   if (attrv->hasAttribute("lat")) {
-    wpt->latitude = attrv->value("lat").toString().toDouble();
+    cur_node_lat = attrv->value("lat").toDouble();
   }
   if (attrv->hasAttribute("lon")) {
-    wpt->longitude = attrv->value("lon").toString().toDouble();
+    cur_node_lon = attrv->value("lon").toDouble();
   }
 
   if (attrv->hasAttribute("timestamp")) {
     QString ts = attrv->value("timestamp").toString();
-    wpt->creation_time = xml_parse_time(ts);
+    cur_node_time = xml_parse_time(ts);
   }
+
+  /* The waypoint, if any, is made by the first tag or at the end. */
 }
 
 
@@ -533,6 +625,10 @@ osm_node_tag(xg_string, const QXmlStreamAttributes* attrv)
 
   QString str = osm_strip_html(value);
 
+  if (wpt == nullptr) {
+    wpt = osm_node_wpt(cur_node_id, cur_node_lat, cur_node_lon, cur_node_time);
+  }
+
   if (key == QLatin1String("name")) {
     if (wpt->shortname.isEmpty()) {
       wpt->shortname = str;
@@ -587,14 +683,21 @@ static void
 osm_way_nd(xg_string, const QXmlStreamAttributes* attrv)
 {
   if (attrv->hasAttribute("ref")) {
-    QString atstr = attrv->value("ref").toString();
+    QStringRef atstr = attrv->value("ref");
+    bool ok;
+    qint64 id = atstr.toLongLong(&ok);
+
+    const osm_node_ref* ref = ok ? osm_find_node(nodes, id) : nullptr;
+    const osm_plain_node* node = (ok && !ref) ? osm_find_node(plain_nodes, id) : nullptr;
 
-    if (waypoints.contains(atstr)) {
-      const Waypoint* ctmp = waypoints.value(atstr);
-      Waypoint* tmp = new Waypoint(*ctmp);
+    if (ref) {
+      Waypoint* tmp = new Waypoint(*ref->wpt);
+      route_add_wpt(rte, tmp);
+    } else if (node) {
+      Waypoint* tmp = osm_node_wpt(id, node->latitude / 1e7, node->longitude / 1e7, node->creation_time);
       route_add_wpt(rte, tmp);
     } else {
-      warning(MYNAME ": Way reference id \"%s\" wasn't listed under nodes!\n", qPrintable(atstr));
+      warning(MYNAME ": Way reference id \"%s\" wasn't listed under nodes!\n", qPrintable(atstr.toString()));
     }
   }
 }
@@ -673,7 +776,8 @@ osm_rd_init(const QString& fname)
   wpt = nullptr;
   rte = nullptr;
 
-  waypoints.clear();
+  nodes.clear();
+  plain_nodes.clear();
   if (keys.isEmpty()) {
     osm_features_init();
   }
@@ -691,7 +795,8 @@ static void
 osm_rd_deinit()
 {
   xml_deinit();
-  waypoints.clear();
+  nodes.clear();
+  plain_nodes.clear();
 }
 
 /*******************************************************************************/
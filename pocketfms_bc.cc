@@ -130,10 +130,10 @@ pocketfms_waypt_disp(const Waypoint* wpt)
   struct breadcrumb bc;
 
   memset(&bc, 0, sizeof(bc));
-  const time_t tt = wpt->GetCreationTime().toTime_t();
+  const time_t tt = wpt->creation_time.toTime_t();
   struct tm* tm = localtime(&tt);
   if (wpt->creation_time.isValid()) {
-    const time_t tt = wpt->GetCreationTime().toTime_t();
+    const time_t tt = wpt->creation_time.toTime_t();
     tm = gmtime(&tt);
   }
 
@@ -19,10 +19,12 @@
 
  */
 
+#include <algorithm>        // for min, max, sort, unique, binary_search, nth_element
+#include <cmath>            // for floor, ceil, fabs
 #include <cstdio>           // for sscanf
-#include <cstring>          // for strchr, strlen, strspn
+#include <cstring>          // for strchr, strlen, strncmp, strspn
 
-#include <QtCore/QtGlobal>  // for foreach
+#include <QtCore/QtGlobal>  // for foreach, qAsConst
 
 #include "defs.h"
 #include "filterdefs.h"     // for global_waypoint_list
@@ -46,11 +48,13 @@
  * ledger, though, the tests for intersection are vastly simplified by always
  * having a horizontal test ray.
  *
- * The general structure of this filter is: we loop over the points in the
- * polygon.  For each point, we update the state of each of the waypoints in
- * the test set.  Thus, the state of every waypoint is indeterminate until
- * the end of the outer loop, at which point the state of every waypoint
- * should theoretically be completely determined.
+ * The general structure of this filter is: for each waypoint in the test
+ * set, we loop over the edges of the polygon in order, updating the state
+ * of the waypoint as we go.  Thus, the state of the waypoint is
+ * indeterminate until the end of the inner loop, at which point it should
+ * theoretically be completely determined.  Edges that don't reach the
+ * latitude of the waypoint can't change its state, so we only visit the
+ * ones filed under its latitude band.
  *
  * The bits following this comment encode the current state of the test point
  * as we go around the polygon.  OUTSIDE clearly isn't a bit; it's just here
@@ -220,12 +224,16 @@ void PolygonFilter::polytest(double lat1, double lon1,
 
 #define BADVAL 999999
 
-void PolygonFilter::process()
+/*
+ * Read the polygon file into a list of edges.  A line beginning with
+ * "#polygon" starts a new, independent polygon; rings within a polygon
+ * combine as islands and holes, while a point inside any of the
+ * polygons counts as inside.
+ */
+void PolygonFilter::polygon_read_file()
 {
-  extra_data* ed;
   int fileline = 0;
   int first = 1;
-  int last = 0;
   char* line;
 
   gbfile* file_in = gbfopen(polyfileopt, "r", MYNAME);
@@ -236,11 +244,20 @@ void PolygonFilter::process()
   double lon1 = BADVAL;
   double lat2 = BADVAL;
   double lon2 = BADVAL;
+  poly_index poly;
+  poly.first_edge = 0;
   while ((line = gbfgetstr(file_in))) {
     fileline++;
 
     char* pound = strchr(line, '#');
     if (pound) {
+      if (0 == strncmp(pound, "#polygon", 8)) {
+        poly.end_edge = edges.size();
+        polys.append(poly);
+        poly.first_edge = edges.size();
+        olat = olon = lat1 = lon1 = BADVAL;
+        first = 1;
+      }
       *pound = '\0';
     }
 
@@ -253,30 +270,16 @@ void PolygonFilter::process()
               fileline);
     } else if (lat1 != BADVAL && lon1 != BADVAL &&
                lat2 != BADVAL && lon2 != BADVAL) {
-      foreach (Waypoint* waypointp, *global_waypoint_list) {
-        if (waypointp->extra_data) {
-          ed = (extra_data*) waypointp->extra_data;
-        } else {
-          ed = (extra_data*) xcalloc(1, sizeof(*ed));
-          ed->state = OUTSIDE;
-          ed->override = 0;
-          waypointp->extra_data = ed;
-        }
-        if (lat2 == waypointp->latitude &&
-            lon2 == waypointp->longitude) {
-          ed->override = 1;
-        }
-        if (olat != BADVAL && olon != BADVAL &&
-            olat == lat2 && olon == lon2) {
-          last = 1;
-        }
-        polytest(lat1, lon1, lat2, lon2,
-                 waypointp->latitude,
-                 waypointp->longitude,
-                 &ed->state, first, last);
-        first = 0;
-        last = 0;
-      }
+      poly_edge edge;
+      edge.lat1 = lat1;
+      edge.lon1 = lon1;
+      edge.lat2 = lat2;
+      edge.lon2 = lon2;
+      edge.first = first;
+      edge.last = (olat != BADVAL && olon != BADVAL &&
+                   olat == lat2 && olon == lon2);
+      edges.append(edge);
+      first = 0;
     }
     if (olat != BADVAL && olon != BADVAL &&
         olat == lat2 && olon == lon2) {
@@ -297,20 +300,149 @@ void PolygonFilter::process()
   }
   gbfclose(file_in);
 
+  poly.end_edge = edges.size();
+  polys.append(poly);
+}
+
+int PolygonFilter::polygon_band(const poly_index& poly, double lat)
+{
+  const int band = floor((lat - poly.min_lat) / poly.band_height);
+  return (band < 0) ? 0 : (band >= poly.bands.size()) ? poly.bands.size() - 1 : band;
+}
+
+/*
+ * An edge can only change the state of a test point whose latitude
+ * lies within the edge's latitude span, so file each edge under every
+ * latitude band it spans.  A point then only walks the edges of its
+ * own band, still in polygon order.  Bands as high as the median edge
+ * keep most edges in one or two of them; while a few long edges would
+ * still blow the index up past a few entries per edge, the bands are
+ * made twice as high.
+ */
+void PolygonFilter::polygon_index(poly_index& poly)
+{
+  poly.min_lat = poly.min_lon = BADVAL;
+  poly.max_lat = poly.max_lon = -BADVAL;
+  for (int i = poly.first_edge; i < poly.end_edge; i++) {
+    const poly_edge& edge = edges.at(i);
+    poly.min_lat = std::min({poly.min_lat, edge.lat1, edge.lat2});
+    poly.max_lat = std::max({poly.max_lat, edge.lat1, edge.lat2});
+    poly.min_lon = std::min({poly.min_lon, edge.lon1, edge.lon2});
+    poly.max_lon = std::max({poly.max_lon, edge.lon1, edge.lon2});
+    poly.vertex_lats.append(edge.lat1);
+    poly.vertex_lats.append(edge.lat2);
+  }
+  std::sort(poly.vertex_lats.begin(), poly.vertex_lats.end());
+  poly.vertex_lats.erase(std::unique(poly.vertex_lats.begin(), poly.vertex_lats.end()),
+                         poly.vertex_lats.end());
+
+  const int nedges = poly.end_edge - poly.first_edge;
+  const double span = poly.max_lat - poly.min_lat;
+  QVector<double> heights;
+  heights.reserve(nedges);
+  for (int i = poly.first_edge; i < poly.end_edge; i++) {
+    heights.append(fabs(edges.at(i).lat2 - edges.at(i).lat1));
+  }
+  auto median = heights.begin() + nedges / 2;
+  std::nth_element(heights.begin(), median, heights.end());
+
+  int nbands = std::max(1, nedges / 2);
+  if ((nedges > 0) && (*median > 0.0)) {
+    nbands = std::max(1, int(std::min<double>(nbands, ceil(span / *median))));
+  }
+  for (;;) {
+    poly.band_height = span / nbands;
+    if (poly.band_height <= 0.0) {
+      poly.band_height = 1.0;
+    }
+    poly.bands.clear();
+    poly.bands.resize(nbands);
+    qint64 entries = 0;
+    for (int i = poly.first_edge; i < poly.end_edge; i++) {
+      const poly_edge& edge = edges.at(i);
+      entries += polygon_band(poly, std::max(edge.lat1, edge.lat2)) -
+                 polygon_band(poly, std::min(edge.lat1, edge.lat2)) + 1;
+    }
+    if ((nbands == 1) || (entries <= 4 * nedges)) {
+      break;
+    }
+    nbands = (nbands + 1) / 2;
+  }
+
+  for (int i = poly.first_edge; i < poly.end_edge; i++) {
+    const poly_edge& edge = edges.at(i);
+    const int lo = polygon_band(poly, std::min(edge.lat1, edge.lat2));
+    const int hi = polygon_band(poly, std::max(edge.lat1, edge.lat2));
+    for (int band = lo; band <= hi; band++) {
+      poly.bands[band].append(i);
+    }
+  }
+}
+
+void PolygonFilter::process()
+{
+  edges.clear();
+  polys.clear();
+  polygon_read_file();
+
+  /* Without a single edge we have no opinion about any point. */
+  if (edges.isEmpty()) {
+    return;
+  }
+  for (auto& poly : polys) {
+    polygon_index(poly);
+  }
+
+  bool first_wpt = true;
   foreach (Waypoint* wp, *global_waypoint_list) {
-    ed = (extra_data*) wp->extra_data;
-    wp->extra_data = nullptr;
-    if (ed) {
-      if (ed->override) {
-        ed->state = INSIDE;
+    bool inside = false;
+    for (const auto& poly : qAsConst(polys)) {
+      if (poly.first_edge == poly.end_edge) {
+        continue;
       }
-      if (((ed->state & INSIDE) == OUTSIDE) == (exclopt == nullptr)) {
-        waypt_del(wp);
-        delete wp;
+      /* Nothing outside the bounding box can be inside the polygon.
+       * A point level with a vertex may still pick up state from the
+       * limbo bookkeeping in polytest, so only trust the longitude
+       * bounds when it isn't. */
+      if (wp->latitude < poly.min_lat || wp->latitude > poly.max_lat) {
+        continue;
+      }
+      if ((wp->longitude < poly.min_lon || wp->longitude > poly.max_lon) &&
+          !std::binary_search(poly.vertex_lats.cbegin(), poly.vertex_lats.cend(),
+                              wp->latitude)) {
+        continue;
+      }
+
+      unsigned short state = OUTSIDE;
+      bool override = false;
+      for (const int i : poly.bands.at(polygon_band(poly, wp->latitude))) {
+        const poly_edge& edge = edges.at(i);
+        if (edge.lat2 == wp->latitude &&
+            edge.lon2 == wp->longitude) {
+          override = true;
+        }
+        /* The start-of-ring state has only ever been tracked for
+         * the first waypoint; keep results unchanged. */
+        polytest(edge.lat1, edge.lon1, edge.lat2, edge.lon2,
+                 wp->latitude,
+                 wp->longitude,
+                 &state, edge.first && first_wpt, edge.last);
+      }
+      if (override || (state & INSIDE)) {
+        inside = true;
+        break;
       }
-      xfree(ed);
+    }
+    first_wpt = false;
+
+    if ((!inside) == (exclopt == nullptr)) {
+      wp->wpt_flags.marked_for_deletion = 1;
     }
   }
+  waypt_del_marked();
+
+  edges.clear();
+  polys.clear();
 }
 
 #endif // FILTERS_ENABLED
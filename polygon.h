@@ -22,6 +22,8 @@
 #ifndef POLYGON_H_INCLUDED_
 #define POLYGON_H_INCLUDED_
 
+#include <QtCore/QVector>  // for QVector
+
 #include "defs.h"    // for ARG_NOMINMAX, arglist_t, ARGTYPE_BOOL, ARGTYPE_FILE
 #include "filter.h"  // for Filter
 
@@ -41,9 +43,26 @@ private:
   char* exclopt = nullptr;
 
   typedef struct {
-    unsigned short state;
-    unsigned short override;
-  } extra_data;
+    double lat1, lon1;
+    double lat2, lon2;
+    bool first;   /* first edge of a ring */
+    bool last;    /* edge closing a ring */
+  } poly_edge;
+
+  /* One polygon: a range of edges plus a bounding box and a
+   * latitude banded index of those edges. */
+  typedef struct {
+    int first_edge;
+    int end_edge;
+    double min_lat, max_lat;
+    double min_lon, max_lon;
+    double band_height;
+    QVector<QVector<int>> bands;
+    QVector<double> vertex_lats;  /* sorted, distinct */
+  } poly_index;
+
+  QVector<poly_edge> edges;
+  QVector<poly_index> polys;
 
   arglist_t args[3] = {
     {
@@ -61,6 +80,9 @@ private:
                 double lat2, double lon2,
                 double wlat, double wlon,
                 unsigned short* state, int first, int last);
+  void polygon_read_file();
+  int polygon_band(const poly_index& poly, double lat);
+  void polygon_index(poly_index& poly);
 
 };
 #endif // FILTERS_ENABLED
@@ -19,11 +19,12 @@
 
  */
 
-#include <cmath>            // for fabs
+#include <cmath>            // for fabs, floor, cos, sin
 #include <cstdlib>          // for strtod
 
-#include <QtCore/QList>     // for QList
-#include <QtCore/QtGlobal>  // for qAsConst, QAddConst<>::Type
+#include <QtCore/QHash>     // for QHash
+#include <QtCore/QVector>   // for QVector
+#include <QtCore/QtGlobal>  // for quint64, Q_UINT64_C
 
 #include "defs.h"
 #include "filterdefs.h"
@@ -42,85 +43,171 @@ double PositionFilter::gc_distance(double lat1, double lon1, double lat2, double
                      ));
 }
 
-/* tear through a waypoint queue, processing points by distance */
-void PositionFilter::position_runqueue(WaypointList* waypt_list, int qtype)
+/*
+ * Waypoints are an unordered set, so every pair has to be considered.
+ * Rather than comparing each point against every later one, bucket them
+ * in a grid of earth-centered cubes at least pos_dist on a side.  Two
+ * points within pos_dist of each other along the surface are even closer
+ * through the earth, so they always fall in the same or adjacent cubes.
+ */
+quint64 PositionFilter::grid_key(const Waypoint* wpt) const
+{
+  const double rlat = RAD(wpt->latitude);
+  const double rlon = RAD(wpt->longitude);
+  const double radius = radtometers(1.0);
+  const double xyz[3] = {
+    radius * cos(rlat) * cos(rlon),
+    radius * cos(rlat) * sin(rlon),
+    radius * sin(rlat)
+  };
+
+  quint64 key = 0;
+  for (const double c : xyz) {
+    // Rounding can nudge a coordinate just past the edge of the globe.
+    const double cell = floor((c + radius) / grid_size);
+    key = (key << kGridBits) | static_cast<quint64>(cell < 0.0 ? 0.0 : cell);
+  }
+  return key;
+}
+
+void PositionFilter::position_runqueue_wpts(WaypointList* waypt_list)
 {
-  QList<WptRecord> qlist;
+  const int nelems = waypt_list->count();
+  const auto wpts = waypt_list->cbegin();
 
-  for (const auto waypointp : qAsConst(*waypt_list)) {
-    qlist.append(WptRecord(waypointp));
+  // Cells hold the indices of their waypoints in ascending order.
+  QHash<quint64, QVector<int>> grid;
+  QVector<quint64> keys(nelems);
+  for (int i = 0; i < nelems; ++i) {
+    keys[i] = grid_key(wpts[i]);
+    grid[keys[i]].append(i);
   }
-  int nelems = qlist.size();
+
+  const quint64 mask = (Q_UINT64_C(1) << kGridBits) - 1;
+  for (int i = 0; i < nelems; ++i) {
+    Waypoint* wpti = wpts[i];
+    if (wpti->wpt_flags.marked_for_deletion) {
+      continue;
+    }
+
+    bool something_deleted = false;
+    const quint64 cx = (keys[i] >> (2 * kGridBits)) & mask;
+    const quint64 cy = (keys[i] >> kGridBits) & mask;
+    const quint64 cz = keys[i] & mask;
+
+    for (quint64 x = cx - 1; x != cx + 2; ++x) {
+      for (quint64 y = cy - 1; y != cy + 2; ++y) {
+        for (quint64 z = cz - 1; z != cz + 2; ++z) {
+          const quint64 key = ((x & mask) << (2 * kGridBits)) | ((y & mask) << kGridBits) | (z & mask);
+          auto cell = grid.find(key);
+          if (cell == grid.end()) {
+            continue;
+          }
+
+          // Points at or before i, and deleted points, will never be
+          // candidates again; drop them from the cell as we go.
+          QVector<int>& members = *cell;
+          int kept = 0;
+          for (int k = 0; k < members.size(); ++k) {
+            const int j = members.at(k);
+            Waypoint* wptj = wpts[j];
+            if ((j <= i) || wptj->wpt_flags.marked_for_deletion) {
+              continue;
+            }
+            members[kept++] = j;
+
+            double dist = gc_distance(wptj->latitude, wptj->longitude,
+                                      wpti->latitude, wpti->longitude);
+            if (dist > pos_dist) {
+              continue;
+            }
+            if (check_time) {
+              double diff_time = fabs(waypt_time(wpti) - waypt_time(wptj));
+              if (diff_time >= max_diff_time) {
+                continue;
+              }
+            }
+            wptj->wpt_flags.marked_for_deletion = 1;
+            something_deleted = true;
+          }
+          members.resize(kept);
+        }
+      }
+    }
+
+    if (something_deleted && (purge_duplicates != nullptr)) {
+      wpti->wpt_flags.marked_for_deletion = 1;
+    }
+  }
+}
+
+/*
+ * Routes and tracks are ordered paths, so only the run of points
+ * immediately following each point is considered.
+ */
+void PositionFilter::position_runqueue_path(WaypointList* waypt_list)
+{
+  const int nelems = waypt_list->count();
+  const auto wpts = waypt_list->cbegin();
 
   for (int i = 0 ; i < nelems ; ++i) {
+    Waypoint* wpti = wpts[i];
     bool something_deleted = false;
 
-    if (!qlist.at(i).deleted) {
+    if (!wpti->wpt_flags.marked_for_deletion) {
       for (int j = i + 1 ; j < nelems ; ++j) {
-        if (!qlist.at(j).deleted) {
-          double dist = gc_distance(qlist.at(j).wpt->latitude,
-                                    qlist.at(j).wpt->longitude,
-                                    qlist.at(i).wpt->latitude,
-                                    qlist.at(i).wpt->longitude);
+        Waypoint* wptj = wpts[j];
+        if (!wptj->wpt_flags.marked_for_deletion) {
+          double dist = gc_distance(wptj->latitude,
+                                    wptj->longitude,
+                                    wpti->latitude,
+                                    wpti->longitude);
 
           if (dist <= pos_dist) {
             if (check_time) {
-              double diff_time = fabs(waypt_time(qlist.at(i).wpt) - waypt_time(qlist.at(j).wpt));
+              double diff_time = fabs(waypt_time(wpti) - waypt_time(wptj));
               if (diff_time >= max_diff_time) {
                 continue;
               }
             }
 
-            qlist[j].deleted = true;
-            switch (qtype) {
-            case wptdata:
-              waypt_del(qlist.at(j).wpt);
-              delete qlist.at(j).wpt;
-              break;
-            case trkdata:
-              track_del_wpt(cur_rte, qlist.at(j).wpt);
-              delete qlist.at(j).wpt;
-              break;
-            case rtedata:
-              route_del_wpt(cur_rte, qlist.at(j).wpt);
-              delete qlist.at(j).wpt;
-              break;
-            default:
-              break;
-            }
+            wptj->wpt_flags.marked_for_deletion = 1;
             something_deleted = true;
           } else {
             // Unlike waypoints, routes and tracks are ordered paths.
             // Don't eliminate points from the return path when the
             // route or track loops back on itself.
-            if ((qtype == trkdata) || (qtype == rtedata)) {
-              break;
-            }
+            break;
           }
         }
       }
 
       if (something_deleted && (purge_duplicates != nullptr)) {
-        switch (qtype) {
-        case wptdata:
-          waypt_del(qlist.at(i).wpt);
-          delete qlist.at(i).wpt;
-          break;
-        case trkdata:
-          track_del_wpt(cur_rte, qlist.at(i).wpt);
-          delete qlist.at(i).wpt;
-          break;
-        case rtedata:
-          route_del_wpt(cur_rte, qlist.at(i).wpt);
-          delete qlist.at(i).wpt;
-          break;
-        default:
-          break;
-        }
+        wpti->wpt_flags.marked_for_deletion = 1;
       }
     }
   }
+}
 
+/* tear through a waypoint queue, processing points by distance */
+void PositionFilter::position_runqueue(WaypointList* waypt_list, int qtype)
+{
+  switch (qtype) {
+  case wptdata:
+    position_runqueue_wpts(waypt_list);
+    waypt_del_marked();
+    break;
+  case trkdata:
+    position_runqueue_path(waypt_list);
+    track_del_marked_wpts(cur_rte);
+    break;
+  case rtedata:
+    position_runqueue_path(waypt_list);
+    route_del_marked_wpts(cur_rte);
+    break;
+  default:
+    break;
+  }
 }
 
 void PositionFilter::position_process_any_route(const route_head* rh, int type)
@@ -176,6 +263,13 @@ void PositionFilter::init()
     check_time = true;
     max_diff_time = strtod(timeopt, &fm);
   }
+
+  // Leave a little slack for rounding, and keep the cells large enough
+  // that each axis index fits in kGridBits.
+  grid_size = pos_dist * 1.001;
+  if (grid_size < kMinGridSize) {
+    grid_size = kMinGridSize;
+  }
 }
 
 #endif // FILTERS_ENABLED
@@ -22,6 +22,8 @@
 #ifndef POSITION_H_INCLUDED_
 #define POSITION_H_INCLUDED_
 
+#include <QtCore/QtGlobal>  // for quint64
+
 #include "defs.h"    // for route_head (ptr only), ARG_NOMINMAX, ARGTYPE_FLOAT
 #include "filter.h"  // for Filter
 
@@ -40,7 +42,13 @@ public:
 private:
   route_head* cur_rte = nullptr;
 
+  /* Each axis of the waypoint grid gets kGridBits of the cell key;
+   * 2^20 cells of 16m span the earth's diameter. */
+  static constexpr int kGridBits = 20;
+  static constexpr double kMinGridSize = 16.0;
+
   double pos_dist;
+  double grid_size;
   double max_diff_time;
   char* distopt = nullptr;
   char* timeopt = nullptr;
@@ -64,16 +72,10 @@ private:
     ARG_TERMINATOR
   };
 
-  class WptRecord
-  {
-  public:
-    Waypoint* wpt{nullptr};
-    bool deleted{false};
-
-    explicit WptRecord(Waypoint* w) : wpt(w) {}
-  };
-
   double gc_distance(double lat1, double lon1, double lat2, double lon2);
+  quint64 grid_key(const Waypoint* wpt) const;
+  void position_runqueue_wpts(WaypointList* waypt_list);
+  void position_runqueue_path(WaypointList* waypt_list);
   void position_runqueue(WaypointList* waypt_list, int qtype);
   void position_process_any_route(const route_head* rh, int type);
   void position_process_rte(const route_head* rh);
@@ -470,7 +470,7 @@ psit_routehdr_w(gbfile* psit_file, const route_head* rte)
     unsigned int rte_datapoints = 0;
     foreach (const Waypoint* testwpt, rte->waypoint_list) {
       if (rte_datapoints == 0) {
-        uniqueValue = testwpt->GetCreationTime().toTime_t();
+        uniqueValue = testwpt->creation_time.toTime_t();
       }
       rte_datapoints++;
     }
@@ -609,7 +609,7 @@ psit_trackhdr_w(gbfile* psit_file, const route_head* trk)
       unsigned int trk_datapoints = 0;
       foreach (const Waypoint* testwpt, trk->waypoint_list) {
         if (trk_datapoints == 0) {
-          uniqueValue = testwpt->GetCreationTime().toTime_t();
+          uniqueValue = testwpt->creation_time.toTime_t();
         }
         trk_datapoints++;
       }
@@ -648,7 +648,7 @@ psit_trackhdr_w_wrapper(const route_head* trk)
 static void
 psit_trackdatapoint_w(gbfile* psit_file, const Waypoint* wpt)
 {
-  time_t	t = wpt->GetCreationTime().toTime_t();
+  time_t	t = wpt->creation_time.toTime_t();
   struct tm* tmTime = gmtime(&t);
 
   gbfprintf(psit_file, "%11.6f,%11.6f,",
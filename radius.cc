@@ -19,9 +19,11 @@
 
  */
 
-#include <cstdlib>          // for atof, atoi, qsort, strtod
+#include <algorithm>        // for partial_sort, sort
+#include <cstdlib>          // for atof, atoi, strtod
 
 #include <QtCore/QString>   // for QString
+#include <QtCore/QVector>   // for QVector
 #include <QtCore/QtGlobal>  // for foreach
 
 #include "defs.h"
@@ -41,28 +43,19 @@ double RadiusFilter::gc_distance(double lat1, double lon1, double lat2, double l
          );
 }
 
-int RadiusFilter::dist_comp(const void* a, const void* b)
+bool RadiusFilter::candidate_before(const candidate& a, const candidate& b)
 {
-  const Waypoint* x1 = *(Waypoint**)a;
-  const Waypoint* x2 = *(Waypoint**)b;
-  extra_data* x1e = (extra_data*) x1->extra_data;
-  extra_data* x2e = (extra_data*) x2->extra_data;
-
-  if (x1e->distance > x2e->distance) {
-    return 1;
-  }
-  if (x1e->distance < x2e->distance) {
-    return -1;
+  if (a.distance != b.distance) {
+    return a.distance < b.distance;
   }
-  return 0;
-
+  return a.seq < b.seq;
 }
 
 void RadiusFilter::process()
 {
-  Waypoint** comp;
-  int i, wc;
-  route_head* rte_head = nullptr;
+  QVector<candidate> comp;
+  comp.reserve(waypt_count());
+
   foreach (Waypoint* waypointp, *global_waypoint_list) {
     double dist = gc_distance(waypointp->latitude,
                        waypointp->longitude,
@@ -73,56 +66,53 @@ void RadiusFilter::process()
     dist = radtomiles(dist);
 
     if ((dist >= pos_dist) == (exclopt == nullptr)) {
-      waypt_del(waypointp);
-      delete waypointp;
+      waypointp->wpt_flags.marked_for_deletion = 1;
       continue;
     }
 
-    extra_data* ed = (extra_data*) xcalloc(1, sizeof(*ed));
-    ed->distance = dist;
-    waypointp->extra_data = ed;
+    comp.append({waypointp, dist, comp.size()});
   }
+  waypt_del_marked();
 
-  wc = waypt_count();
-
-  comp = (Waypoint**) xcalloc(wc, sizeof(*comp));
-
-  i = 0;
+  const int wc = comp.size();
+  int keep = wc;
+  if (maxctarg && maxct < wc) {
+    keep = (maxct > 0) ? maxct : 0;
+  }
 
   /*
-   * Create an array of remaining waypoints, popping them off the
-   * master queue as we go.   This gives us something reasonable
-   * for qsort.
+   * Order by distance, ties in input order.  When only the closest
+   * maxcount are wanted, a partial sort (a bounded heap) of those is
+   * enough; the others don't need to be ordered at all.
    */
-
-  foreach (Waypoint* wp, *global_waypoint_list) {
-    comp[i] = wp;
-    waypt_del(wp);
-    i++;
-  }
-
   if (!nosort) {
-    qsort(comp, wc, sizeof(Waypoint*), dist_comp);
+    if (keep < wc) {
+      std::partial_sort(comp.begin(), comp.begin() + keep, comp.end(), candidate_before);
+    } else {
+      std::sort(comp.begin(), comp.end(), candidate_before);
+    }
   }
 
+  /*
+   * Take the survivors off the master list in one go and push them back
+   * in the new order, letting us pass them on through in the modified
+   * order.
+   */
+  WaypointList unsorted;
+  waypt_swap(unsorted);
+
+  route_head* rte_head = nullptr;
   if (routename) {
     rte_head = route_head_alloc();
     rte_head->rte_name = routename;
     route_add_head(rte_head);
   }
 
-  /*
-   * The comp array is now sorted by distance.   As we run through it,
-   * we push them back onto the master wp list, letting us pass them
-   * on through in the modified order.
-   */
-  for (i = 0; i < wc; i++) {
-    Waypoint* wp = comp[i];
+  for (int i = 0; i < wc; i++) {
+    Waypoint* wp = comp.at(i).wpt;
 
-    xfree(wp->extra_data);
-    wp->extra_data = nullptr;
-
-    if (maxctarg && i >= maxct) {
+    if (i >= keep) {
+      delete wp;
       continue;
     }
     if (routename) {
@@ -131,8 +121,6 @@ void RadiusFilter::process()
       waypt_add(wp);
     }
   }
-
-  xfree(comp);
 }
 
 void RadiusFilter::init()
@@ -51,9 +51,11 @@ private:
 
   Waypoint* home_pos;
 
-  typedef struct {
+  struct candidate {
+    Waypoint* wpt;
     double distance;
-  } extra_data;
+    int seq;
+  };
 
   arglist_t args[8] = {
     {
@@ -88,7 +90,7 @@ private:
   };
 
   double gc_distance(double lat1, double lon1, double lat2, double lon2);
-  static int dist_comp(const void* a, const void* b);
+  static bool candidate_before(const candidate& a, const candidate& b);
 
 };
 #endif // FILTERS_ENABLED
@@ -337,7 +337,7 @@ write_waypoint(gbfile* fout, const Waypoint* wpt, const int waypt_no, const char
     }
   }
   notes = csv_stringclean(notes, LINE_FEED);
-  double time = wpt->creation_time.isValid() ? TIMET_TO_EXCEL(wpt->GetCreationTime().toTime_t()) : TIMET_TO_EXCEL(gpsbabel_time);
+  double time = wpt->creation_time.isValid() ? TIMET_TO_EXCEL(wpt->creation_time.toTime_t()) : TIMET_TO_EXCEL(gpsbabel_time);
   char* name = (char*)wpt->extra_data;
 
   gbfprintf(fout, "[Wp%d]" LINE_FEED
@@ -19,8 +19,9 @@
 
 #include <cassert>              // for assert
 #include <cstddef>              // for nullptr_t
-#include <algorithm>            // for sort
+#include <algorithm>            // for max, min, sort, swap
 #include <iterator>
+#include <vector>               // for vector
 
 #include <QtCore/QDateTime>     // for QDateTime
 #include <QtCore/QList>         // for QList<>::iterator
@@ -28,7 +29,8 @@
 #include <QtCore/QtGlobal>      // for foreach
 
 #include "defs.h"
-#include "grtcirc.h"            // for RAD, gcdist, heading_true_degrees, radtometers
+#include "filter.h"             // for Filter
+#include "grtcirc.h"            // for RAD, gcdist_heading_path, radtometers
 #include "session.h"            // for curr_session, session_t (ptr only)
 #include "src/core/datetime.h"  // for DateTime
 #include "src/core/optional.h"  // for optional, operator>, operator<
@@ -150,6 +152,18 @@ track_del_wpt(route_head* rte, Waypoint* wpt)
   global_track_list->del_wpt(rte, wpt);
 }
 
+void
+route_del_marked_wpts(route_head* rte)
+{
+  global_route_list->del_marked_wpts(rte);
+}
+
+void
+track_del_marked_wpts(route_head* rte)
+{
+  global_track_list->del_marked_wpts(rte);
+}
+
 void
 route_disp(const route_head* /* rh */, std::nullptr_t /* wc */)
 {
@@ -192,13 +206,13 @@ route_deinit()
 void
 route_append(RouteList* src)
 {
-  src->copy(&global_route_list);
+  global_route_list->splice(src);
 }
 
 void
 track_append(RouteList* src)
 {
-  src->copy(&global_track_list);
+  global_track_list->splice(src);
 }
 
 void
@@ -259,52 +273,62 @@ track_sort(RouteList::Compare cmp)
  */
 computed_trkdata track_recompute(const route_head* trk)
 {
-  Waypoint first;
-  const Waypoint* prev = &first;
   int tkpt = 0;
   int pts_hrt = 0;
   double tot_hrt = 0.0;
   int pts_cad = 0;
   double tot_cad = 0.0;
   computed_trkdata tdata;
+  const Waypoint* startw = nullptr;
+  const Waypoint* endw = nullptr;
+
+  /*
+   * The legs are computed up front from the coordinates alone, which
+   * lets neighbouring legs share their trigonometry.  The course of the
+   * first point is relative to 0,0, so that's where the path starts.
+   * gcdist and heading want radians, not degrees.
+   */
+  const int npts = trk->waypoint_list.count() + 1;
+  std::vector<double> lat(npts);
+  std::vector<double> lon(npts);
+  std::vector<double> dist(npts);
+  std::vector<double> course(npts);
+  lat[0] = lon[0] = 0;
+  int pt = 1;
+  foreach (const Waypoint* thisw, trk->waypoint_list) {
+    lat[pt] = RAD(thisw->latitude);
+    lon[pt] = RAD(thisw->longitude);
+    pt++;
+  }
+  gcdist_heading_path(npts, lat.data(), lon.data(), dist.data(), course.data());
 
-//  first.latitude = 0;
-//  first.longitude = 0;
-//  first.creation_time = 0;
-
+  Waypoint first;
+  const Waypoint* prev = &first;
   foreach (Waypoint* thisw, trk->waypoint_list) {
 
-    /*
-     * gcdist and heading want radians, not degrees.
-     */
-    double tlat = RAD(thisw->latitude);
-    double tlon = RAD(thisw->longitude);
-    double plat = RAD(prev->latitude);
-    double plon = RAD(prev->longitude);
-    WAYPT_SET(thisw, course, heading_true_degrees(plat, plon,
-              tlat, tlon));
-    double dist = radtometers(gcdist(plat, plon, tlat, tlon));
+    WAYPT_SET(thisw, course, course[tkpt]);
+    double dist_m = radtometers(dist[tkpt]);
 
     /*
      * Avoid that 6300 mile jump as we move from 0,0.
      */
-    if (plat && plon) {
-      tdata.distance_meters += dist;
+    if (lat[tkpt] && lon[tkpt]) {
+      tdata.distance_meters += dist_m;
     }
 
     /*
      * If we've moved as much as a meter,
      * conditionally recompute speeds.
      */
-    if (!WAYPT_HAS(thisw, speed) && (dist > 1)) {
+    if (!WAYPT_HAS(thisw, speed) && (dist_m > 1)) {
       // Only recompute speed if the waypoint
       // didn't already have a speed
-      if (thisw->GetCreationTime().isValid() &&
-          prev->GetCreationTime().isValid() &&
-          thisw->GetCreationTime() > prev->GetCreationTime()) {
+      if (thisw->creation_time.isValid() &&
+          prev->creation_time.isValid() &&
+          thisw->creation_time.toMSecsSinceEpoch() > prev->creation_time.toMSecsSinceEpoch()) {
         double timed =
-          prev->GetCreationTime().msecsTo(thisw->GetCreationTime()) / 1000.0;
-        WAYPT_SET(thisw, speed, dist / timed);
+          prev->creation_time.msecsTo(thisw->creation_time) / 1000.0;
+        WAYPT_SET(thisw, speed, dist_m / timed);
       }
     }
     if (WAYPT_HAS(thisw, speed)) {
@@ -348,13 +372,14 @@ computed_trkdata track_recompute(const route_head* trk)
       tdata.max_cad = thisw->cadence;
     }
 
-    if (thisw->GetCreationTime().isValid()) {
-      if (!tdata.start.isValid() || (thisw->GetCreationTime() < tdata.start)) {
-        tdata.start = thisw->GetCreationTime();
+    if (thisw->creation_time.isValid()) {
+      qint64 t = thisw->creation_time.toMSecsSinceEpoch();
+      if (!startw || (t < startw->creation_time.toMSecsSinceEpoch())) {
+        startw = thisw;
       }
 
-      if (!tdata.end.isValid() || (thisw->GetCreationTime() > tdata.end)) {
-        tdata.end = thisw->GetCreationTime();
+      if (!endw || (t > endw->creation_time.toMSecsSinceEpoch())) {
+        endw = thisw;
       }
     }
 
@@ -365,6 +390,11 @@ computed_trkdata track_recompute(const route_head* trk)
     prev = thisw;
   }
 
+  if (startw) {
+    tdata.start = startw->GetCreationTime();
+    tdata.end = endw->GetCreationTime();
+  }
+
   if (pts_hrt > 0) {
     tdata.avg_hrt = tot_hrt / pts_hrt;
   }
@@ -376,6 +406,180 @@ computed_trkdata track_recompute(const route_head* trk)
   return tdata;
 }
 
+/*
+ * Track streaming.
+ *
+ * While a stream is open a reader may release points from the front of
+ * the first track once it won't touch them again.  They are handed through
+ * the filters to the writer's callbacks and deleted right away, so a long
+ * track never has to be held in memory as a whole.  Whatever is still held
+ * when the stream ends is handed on in the usual order.
+ *
+ * The extent of the points that reached the writer is kept until the next
+ * stream begins, the writer picks it up with track_stream_add_bounds().
+ */
+static bool stream_open = false;
+static route_hdr stream_rh = nullptr;
+static route_trl stream_rt = nullptr;
+static waypt_cb stream_wc = nullptr;
+static QList<Filter*> stream_filters;
+static const route_head* stream_trk = nullptr;	/* track being streamed */
+static int stream_reach = 0;		/* filters that see its points */
+static bool stream_write = false;	/* all of them took it */
+static int stream_stage = 0;		/* filter looking at a point */
+static std::vector<bool> stream_seg;	/* segment start dropped by a filter */
+static bool stream_have_extent = false;
+static bounds stream_extent;
+
+static void
+track_stream_start(const route_head* trk)
+{
+  stream_trk = trk;
+  stream_reach = 0;
+  stream_write = true;
+  while (stream_write && (stream_reach < stream_filters.size())) {
+    stream_write = stream_filters.at(stream_reach++)->stream_track(trk);
+  }
+  std::fill(stream_seg.begin(), stream_seg.end(), false);
+
+  if (stream_write && stream_rh) {
+    stream_rh(trk);
+  }
+}
+
+static void
+track_stream_pass(Waypoint* wpt, int stage)
+{
+  for (int i = stage; i < stream_reach; i++) {
+    stream_stage = i;
+    if (!stream_filters.at(i)->stream_point(wpt)) {
+      /* Like a deletion from the track, hand a segment start on. */
+      if (wpt->wpt_flags.new_trkseg) {
+        stream_seg[i] = true;
+      }
+      return;
+    }
+    if (stream_seg[i]) {
+      wpt->wpt_flags.new_trkseg = 1;
+      stream_seg[i] = false;
+    }
+  }
+  if (!stream_write) {
+    return;
+  }
+
+  waypt_add_to_bounds(&stream_extent, wpt);
+  if (stream_wc) {
+    stream_wc(wpt);
+  }
+}
+
+void
+track_stream_begin(route_hdr rh, route_trl rt, waypt_cb wc, const QList<Filter*>& filters)
+{
+  stream_open = true;
+  stream_rh = rh;
+  stream_rt = rt;
+  stream_wc = wc;
+  stream_filters = filters;
+  stream_trk = nullptr;
+  stream_reach = 0;
+  stream_write = false;
+  stream_stage = 0;
+  stream_seg.assign(filters.size(), false);
+  waypt_init_bounds(&stream_extent);
+  stream_have_extent = true;
+}
+
+bool
+track_stream_open()
+{
+  return stream_open;
+}
+
+void
+track_stream_release(route_head* trk, int count)
+{
+  if (!stream_open || global_track_list->empty() || (trk != global_track_list->front())) {
+    return;
+  }
+
+  /* Keep the last point, the track must never be seen empty. */
+  count = std::min(count, trk->waypoint_list.count() - 1);
+  if (count <= 0) {
+    return;
+  }
+
+  if (stream_trk != trk) {
+    track_stream_start(trk);
+  }
+
+  auto it = trk->waypoint_list.begin();
+  for (int i = 0; i < count; i++, ++it) {
+    Waypoint* wpt = *it;
+    track_stream_pass(wpt, 0);
+    wpt->wpt_flags.marked_for_deletion = 1;
+  }
+  /* The released points are written, a segment start stays with them. */
+  global_track_list->del_marked_wpts(trk, false);
+}
+
+/*
+ * Called by the filter looking at a point, to hand another point on to
+ * the filters after it ahead of that one.  The point is deleted.
+ */
+void
+track_stream_insert(Waypoint* wpt)
+{
+  int stage = stream_stage;
+  track_stream_pass(wpt, stage + 1);
+  stream_stage = stage;
+  delete wpt;
+}
+
+void
+track_stream_end()
+{
+  if (!stream_open) {
+    return;
+  }
+
+  foreach (const route_head* rhp, *global_track_list) {
+    if (rhp != stream_trk) {
+      track_stream_start(rhp);
+    }
+    foreach (Waypoint* wpt, rhp->waypoint_list) {
+      track_stream_pass(wpt, 0);
+    }
+    if (stream_write && stream_rt) {
+      stream_rt(rhp);
+    }
+  }
+  route_flush_all_tracks();
+
+  stream_open = false;
+  stream_rh = nullptr;
+  stream_rt = nullptr;
+  stream_wc = nullptr;
+  stream_filters.clear();
+  stream_trk = nullptr;
+}
+
+void
+track_stream_add_bounds(bounds* bounds)
+{
+  if (!stream_have_extent || !waypt_bounds_valid(&stream_extent)) {
+    return;
+  }
+
+  bounds->max_lat = std::max(bounds->max_lat, stream_extent.max_lat);
+  bounds->max_lon = std::max(bounds->max_lon, stream_extent.max_lon);
+  bounds->max_alt = std::max(bounds->max_alt, stream_extent.max_alt);
+  bounds->min_lat = std::min(bounds->min_lat, stream_extent.min_lat);
+  bounds->min_lon = std::min(bounds->min_lon, stream_extent.min_lon);
+  bounds->min_alt = std::min(bounds->min_alt, stream_extent.min_alt);
+}
+
 route_head::route_head() :
   rte_num(0),
   rte_waypt_ct(0),
@@ -451,6 +655,15 @@ RouteList::del_wpt(route_head* rte, Waypoint* wpt)
   --waypt_ct;
 }
 
+void
+RouteList::del_marked_wpts(route_head* rte, bool keep_trkseg)
+{
+  const int removed = keep_trkseg ? rte->waypoint_list.del_marked_rte_wpts() :
+                      rte->waypoint_list.waypt_del_marked();
+  rte->rte_waypt_ct -= removed;
+  waypt_ct -= removed;
+}
+
 void
 RouteList::common_disp_session(const session_t* se, route_hdr rh, route_trl rt, waypt_cb wc)
 {
@@ -511,11 +724,30 @@ RouteList::restore(RouteList* src)
   src->waypt_ct = 0;
 }
 
+void
+RouteList::splice(RouteList* src)
+{
+  if (src == nullptr || src == this) {
+    return;
+  }
+  const bool global = (this == global_route_list) || (this == global_track_list);
+  foreach (route_head* rte, *src) {
+    add_head(rte);
+    waypt_ct += rte->rte_waypt_ct;
+    if (global) {
+      foreach (const Waypoint* wpt, rte->waypoint_list) {
+        update_common_traits(wpt);
+      }
+    }
+  }
+  src->clear();
+  src->waypt_ct = 0;
+}
+
 void RouteList::swap(RouteList& other)
 {
-  const RouteList tmp_list = *this;
-  *this = other;
-  other = tmp_list;
+  QList<route_head*>::swap(other);
+  std::swap(waypt_ct, other.waypt_ct);
 }
 
 void RouteList::sort(Compare cmp)
@@ -60,6 +60,7 @@
 #include "filterdefs.h"
 #include "grtcirc.h"
 #include "smplrout.h"
+#include <cmath>
 #include <cstdlib>
 
 #if FILTERS_ENABLED
@@ -67,11 +68,6 @@
 
 #define sqr(a) ((a)*(a))
 
-void SimplifyRouteFilter::free_xte(struct xte* xte_rec)
-{
-  xfree(xte_rec->intermed);
-}
-
 #define HUGEVAL 2000000000
 
 void SimplifyRouteFilter::routesimple_waypt_pr(const Waypoint* wpt)
@@ -79,105 +75,193 @@ void SimplifyRouteFilter::routesimple_waypt_pr(const Waypoint* wpt)
   if (!cur_rte) {
     return;
   }
-  xte_recs[xte_count].ordinal=xte_count;
-  xte_recs[xte_count].intermed = (struct xte_intermed*) xmalloc(sizeof(struct xte_intermed));
-  xte_recs[xte_count].intermed->wpt = wpt;
-  xte_recs[xte_count].intermed->xte_rec = xte_recs+xte_count;
-  xte_recs[xte_count].intermed->next = nullptr;
-  xte_recs[xte_count].intermed->prev = tmpprev;
-  if (tmpprev) {
-    tmpprev->next = xte_recs[xte_count].intermed;
+  xte rec;
+  rec.distance = 0;
+  rec.prev = xte_count - 1;
+  rec.next = -1;
+  rec.heap_pos = xte_count;
+  rec.tiebreak = xte_count;
+  rec.wpt = wpt;
+  if (xte_count) {
+    xte_recs[xte_count - 1].next = xte_count;
   }
-  tmpprev = xte_recs[xte_count].intermed;
+  xte_recs.append(rec);
   xte_count++;
 }
 
-void SimplifyRouteFilter::compute_xte(struct xte* xte_rec)
+void SimplifyRouteFilter::compute_xte(xte& xte_rec)
 {
-  const Waypoint* wpt3 = xte_rec->intermed->wpt;
+  const Waypoint* wpt3 = xte_rec.wpt;
   double reslat, reslon;
   /* if no previous, this is an endpoint and must be preserved. */
-  if (!xte_rec->intermed->prev) {
-    xte_rec->distance = HUGEVAL;
+  if (xte_rec.prev < 0) {
+    xte_rec.distance = HUGEVAL;
     return;
   }
-  const Waypoint* wpt1 = xte_rec->intermed->prev->wpt;
+  const Waypoint* wpt1 = xte_recs.at(xte_rec.prev).wpt;
 
   /* if no next, this is an endpoint and must be preserved. */
-  if (!xte_rec->intermed->next) {
-    xte_rec->distance = HUGEVAL;
+  if (xte_rec.next < 0) {
+    xte_rec.distance = HUGEVAL;
     return;
   }
-  const Waypoint* wpt2 = xte_rec->intermed->next->wpt;
+  const Waypoint* wpt2 = xte_recs.at(xte_rec.next).wpt;
 
   if (xteopt) {
-    xte_rec->distance = radtomiles(linedist(
-                                     wpt1->latitude, wpt1->longitude,
-                                     wpt2->latitude, wpt2->longitude,
-                                     wpt3->latitude, wpt3->longitude));
+    xte_rec.distance = radtomiles(linedist(
+                                    wpt1->latitude, wpt1->longitude,
+                                    wpt2->latitude, wpt2->longitude,
+                                    wpt3->latitude, wpt3->longitude));
   } else if (lenopt) {
-    xte_rec->distance = radtomiles(
-                          gcdist(wpt1->latitude, wpt1->longitude,
-                                 wpt3->latitude, wpt3->longitude) +
-                          gcdist(wpt3->latitude, wpt3->longitude,
-                                 wpt2->latitude, wpt2->longitude) -
-                          gcdist(wpt1->latitude, wpt1->longitude,
-                                 wpt2->latitude, wpt2->longitude));
+    xte_rec.distance = radtomiles(
+                         gcdist(wpt1->latitude, wpt1->longitude,
+                                wpt3->latitude, wpt3->longitude) +
+                         gcdist(wpt3->latitude, wpt3->longitude,
+                                wpt2->latitude, wpt2->longitude) -
+                         gcdist(wpt1->latitude, wpt1->longitude,
+                                wpt2->latitude, wpt2->longitude));
   } else if (relopt) {
     if (wpt3->hdop == 0) {
       fatal(MYNAME ": relative needs hdop information.\n");
     }
     // if timestamps exist, distance to interpolated point
     if (wpt1->GetCreationTime() != wpt2->GetCreationTime()) {
-      double frac = (double)(wpt3->GetCreationTime().toTime_t() - wpt1->GetCreationTime().toTime_t()) /
-        (wpt2->GetCreationTime().toTime_t() - wpt1->GetCreationTime().toTime_t());
+      double frac = (double)(wpt3->creation_time.toTime_t() - wpt1->creation_time.toTime_t()) /
+        (wpt2->creation_time.toTime_t() - wpt1->creation_time.toTime_t());
       linepart(wpt1->latitude, wpt1->longitude,
                wpt2->latitude, wpt2->longitude,
                frac, &reslat, &reslon);
-      xte_rec->distance = radtometers(gcdist(
-                                        wpt3->latitude, wpt3->longitude,
-                                        reslat, reslon));
+      xte_rec.distance = radtometers(gcdist(
+                                       wpt3->latitude, wpt3->longitude,
+                                       reslat, reslon));
     } else { // else distance to connecting line
-      xte_rec->distance = radtometers(linedist(
-                                        wpt1->latitude, wpt1->longitude,
-                                        wpt2->latitude, wpt2->longitude,
-                                        wpt3->latitude, wpt3->longitude));
+      xte_rec.distance = radtometers(linedist(
+                                       wpt1->latitude, wpt1->longitude,
+                                       wpt2->latitude, wpt2->longitude,
+                                       wpt3->latitude, wpt3->longitude));
     }
     // error relative to horizontal precision
-    xte_rec->distance /= (6 * wpt3->hdop);
+    xte_rec.distance /= (6 * wpt3->hdop);
     // (hdop->meters following to J. Person at <http://www.developerfusion.co.uk/show/4652/3/>)
 
+  } else if (visopt) {
+    /* Area of the triangle between the three points in earth-centered
+     * coordinates.  For the small triangles we care about, that's the
+     * area on the surface to well within the precision of the input. */
+    const Waypoint* wpts[3] = {wpt1, wpt3, wpt2};
+    double xyz[3][3];
+    for (int i = 0; i < 3; i++) {
+      const double rlat = RAD(wpts[i]->latitude);
+      const double rlon = RAD(wpts[i]->longitude);
+      xyz[i][0] = cos(rlat) * cos(rlon);
+      xyz[i][1] = cos(rlat) * sin(rlon);
+      xyz[i][2] = sin(rlat);
+    }
+    double u[3], v[3];
+    for (int i = 0; i < 3; i++) {
+      u[i] = xyz[1][i] - xyz[0][i];
+      v[i] = xyz[2][i] - xyz[0][i];
+    }
+    const double cx = u[1] * v[2] - u[2] * v[1];
+    const double cy = u[2] * v[0] - u[0] * v[2];
+    const double cz = u[0] * v[1] - u[1] * v[0];
+    const double area = sqrt(sqr(cx) + sqr(cy) + sqr(cz)) / 2.0;
+    xte_rec.distance = radtomiles(sqrt(area));
   }
 }
 
-int SimplifyRouteFilter::compare_xte(const void* a, const void* b)
+/*
+ * True if entry a should be removed before entry b: endpoints last,
+ * then lower route priority first, then smaller error first.  Ties go
+ * to the higher tiebreak, which reproduces the order the points used to
+ * have in a sorted array: initially by position, and after a recompute
+ * behind its new equals if its error fell, ahead of them if it rose.
+ */
+bool SimplifyRouteFilter::xte_before(const xte_heap_entry& a, const xte_heap_entry& b)
 {
-  double distdiff = ((struct xte*)a)->distance -
-                    ((struct xte*)b)->distance;
-  int priodiff = ((struct xte*)a)->intermed->wpt->route_priority -
-                 ((struct xte*)b)->intermed->wpt->route_priority;
-
-  if (HUGEVAL == ((struct xte*)a)->distance) {
-    return -1;
+  if ((HUGEVAL == a.distance) != (HUGEVAL == b.distance)) {
+    return HUGEVAL == b.distance;
   }
-
-  if (HUGEVAL == ((struct xte*)b)->distance) {
-    return 1;
+  if (HUGEVAL != a.distance) {
+    if (a.priority != b.priority) {
+      return a.priority < b.priority;
+    }
+    if (a.distance != b.distance) {
+      return a.distance < b.distance;
+    }
   }
+  return a.tiebreak > b.tiebreak;
+}
+
+void SimplifyRouteFilter::xte_heap_place(int i, const xte_heap_entry& entry)
+{
+  xte_heap[i] = entry;
+  xte_recs[entry.rec].heap_pos = i;
+}
 
-  if (priodiff < 0) {
-    return 1;
+void SimplifyRouteFilter::xte_heap_up(int i)
+{
+  const xte_heap_entry entry = xte_heap.at(i);
+  while (i > 0) {
+    const int parent = (i - 1) / 2;
+    if (!xte_before(entry, xte_heap.at(parent))) {
+      break;
+    }
+    xte_heap_place(i, xte_heap.at(parent));
+    i = parent;
   }
-  if (priodiff > 0) {
-    return -1;
+  xte_heap_place(i, entry);
+}
+
+void SimplifyRouteFilter::xte_heap_down(int i)
+{
+  const int n = xte_heap.size();
+  const xte_heap_entry entry = xte_heap.at(i);
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= n) {
+      break;
+    }
+    if (child + 1 < n && xte_before(xte_heap.at(child + 1), xte_heap.at(child))) {
+      child++;
+    }
+    if (!xte_before(xte_heap.at(child), entry)) {
+      break;
+    }
+    xte_heap_place(i, xte_heap.at(child));
+    i = child;
   }
-  if (distdiff < 0) {
-    return 1;
+  xte_heap_place(i, entry);
+}
+
+/* Recompute a record's error and move it to its new place in the heap. */
+void SimplifyRouteFilter::xte_heap_update(int rec)
+{
+  xte& xte_rec = xte_recs[rec];
+  const double old_distance = xte_rec.distance;
+  compute_xte(xte_rec);
+  if (xte_rec.distance == HUGEVAL || xte_rec.distance < old_distance) {
+    xte_rec.tiebreak = tiebreak_lo--;
+  } else if (xte_rec.distance > old_distance) {
+    xte_rec.tiebreak = tiebreak_hi++;
   }
-  if (distdiff > 0) {
-    return -1;
+  xte_heap_entry& entry = xte_heap[xte_rec.heap_pos];
+  entry.distance = xte_rec.distance;
+  entry.tiebreak = xte_rec.tiebreak;
+  xte_heap_up(xte_rec.heap_pos);
+  xte_heap_down(xte_rec.heap_pos);
+}
+
+int SimplifyRouteFilter::xte_heap_pop()
+{
+  const int rec = xte_heap.at(0).rec;
+  const xte_heap_entry last = xte_heap.last();
+  xte_heap.removeLast();
+  if (!xte_heap.isEmpty()) {
+    xte_heap_place(0, last);
+    xte_heap_down(0);
   }
-  return 0;
+  return rec;
 }
 
 void SimplifyRouteFilter::routesimple_head(const route_head* rte)
@@ -185,7 +269,8 @@ void SimplifyRouteFilter::routesimple_head(const route_head* rte)
   cur_rte = nullptr;
   /* build array of XTE/wpt xref records */
   xte_count = 0;
-  tmpprev = nullptr;
+  xte_recs.clear();
+  xte_heap.clear();
   totalerror = 0;
 
   /* short-circuit if we already have fewer than the max points */
@@ -198,114 +283,81 @@ void SimplifyRouteFilter::routesimple_head(const route_head* rte)
     return;
   }
 
-  xte_recs = (struct xte*) xcalloc(rte->rte_waypt_ct, sizeof(struct xte));
+  xte_recs.reserve(rte->rte_waypt_ct);
   cur_rte = rte;
 
 }
 
-void SimplifyRouteFilter::shuffle_xte(struct xte* xte_rec)
-{
-  struct xte tmp_xte;
-  while (xte_rec > xte_recs && compare_xte(xte_rec, xte_rec-1) < 0) {
-    tmp_xte.distance = xte_rec->distance;
-    tmp_xte.ordinal = xte_rec->ordinal;
-    tmp_xte.intermed = xte_rec->intermed;
-    xte_rec->distance = xte_rec[-1].distance;
-    xte_rec->ordinal = xte_rec[-1].ordinal;
-    xte_rec->intermed = xte_rec[-1].intermed;
-    xte_rec->intermed->xte_rec = xte_rec;
-    xte_rec--;
-    xte_rec->distance = tmp_xte.distance;
-    xte_rec->ordinal = tmp_xte.ordinal;
-    xte_rec->intermed = tmp_xte.intermed;
-    xte_rec->intermed->xte_rec = xte_rec;
-  }
-  while (xte_rec - xte_recs < xte_count-2 &&
-         compare_xte(xte_rec, xte_rec+1) > 0) {
-    tmp_xte.distance = xte_rec->distance;
-    tmp_xte.ordinal = xte_rec->ordinal;
-    tmp_xte.intermed = xte_rec->intermed;
-    xte_rec->distance = xte_rec[1].distance;
-    xte_rec->ordinal = xte_rec[1].ordinal;
-    xte_rec->intermed = xte_rec[1].intermed;
-    xte_rec->intermed->xte_rec = xte_rec;
-    xte_rec++;
-    xte_rec->distance = tmp_xte.distance;
-    xte_rec->ordinal = tmp_xte.ordinal;
-    xte_rec->intermed = tmp_xte.intermed;
-    xte_rec->intermed->xte_rec = xte_rec;
-  }
-}
-
 void SimplifyRouteFilter::routesimple_tail(const route_head* rte)
 {
-  int i;
   if (!cur_rte) {
     return;
   }
 
-  /* compute all distances */
-  for (i = 0; i < xte_count ; i++) {
-    compute_xte(xte_recs+i);
+  /* compute all distances, and heapify with the next point to go on top */
+  tiebreak_lo = -1;
+  tiebreak_hi = xte_count;
+  xte_heap.resize(xte_count);
+  for (int i = 0; i < xte_count ; i++) {
+    compute_xte(xte_recs[i]);
+    xte_heap[i].distance = xte_recs.at(i).distance;
+    xte_heap[i].priority = xte_recs.at(i).wpt->route_priority;
+    xte_heap[i].tiebreak = xte_recs.at(i).tiebreak;
+    xte_heap[i].rec = i;
   }
-
-
-  /* sort XTE array, lowest XTE last */
-  qsort(xte_recs, xte_count, sizeof(struct xte), compare_xte);
-
-  for (i = 0; i < xte_count; i++) {
-    xte_recs[i].intermed->xte_rec = xte_recs+i;
+  for (int i = xte_count / 2 - 1; i >= 0; i--) {
+    xte_heap_down(i);
   }
+
   // Ensure totalerror starts with the distance between first and second points
   // and not the zero-init.  From a June 25, 2014  thread titled "Simplify
   // Filter: GPSBabel removes one trackpoint..."  I never could repro it it
   // with the sample data, so there is no automated test case, but Steve's
   // fix is "obviously" right here.
   if (xte_count >= 1) {
-    totalerror = xte_recs[xte_count-1].distance;
+    totalerror = xte_heap.at(0).distance;
   }
 
   /* while we still have too many records... */
   while ((xte_count) && ((countopt && count < xte_count) || (erroropt && totalerror < error))) {
-    i = xte_count - 1;
     /* remove the record with the lowest XTE */
+    const int i = xte_heap_pop();
+    xte& rec = xte_recs[i];
     if (erroropt) {
-      if (xteopt || relopt) {
-        if (i > 1) {
-          totalerror = xte_recs[i-1].distance;
+      if (xteopt || relopt || visopt) {
+        /* the error of the next candidate, before the neighbors move */
+        if (!xte_heap.isEmpty() && xte_count > 2) {
+          totalerror = xte_heap.at(0).distance;
         } else {
-          totalerror = xte_recs[i].distance;
+          totalerror = rec.distance;
         }
       }
       if (lenopt) {
-        totalerror += xte_recs[i].distance;
+        totalerror += rec.distance;
       }
     }
-    (*waypt_del_fnp)((route_head*)(void*)rte,
-                     (Waypoint*)(void*)(xte_recs[i].intermed->wpt));
-    delete (Waypoint*)(void*)(xte_recs[i].intermed->wpt);
-
-    if (xte_recs[i].intermed->prev) {
-      xte_recs[i].intermed->prev->next = xte_recs[i].intermed->next;
-      compute_xte(xte_recs[i].intermed->prev->xte_rec);
-      shuffle_xte(xte_recs[i].intermed->prev->xte_rec);
+    const_cast<Waypoint*>(rec.wpt)->wpt_flags.marked_for_deletion = 1;
+
+    if (rec.prev >= 0) {
+      xte_recs[rec.prev].next = rec.next;
+    }
+    if (rec.next >= 0) {
+      xte_recs[rec.next].prev = rec.prev;
     }
-    if (xte_recs[i].intermed->next) {
-      xte_recs[i].intermed->next->prev = xte_recs[i].intermed->prev;
-      compute_xte(xte_recs[i].intermed->next->xte_rec);
-      shuffle_xte(xte_recs[i].intermed->next->xte_rec);
+    if (rec.prev >= 0) {
+      xte_heap_update(rec.prev);
+    }
+    if (rec.next >= 0) {
+      xte_heap_update(rec.next);
     }
     xte_count--;
-    free_xte(xte_recs+xte_count);
     /* end of loop */
   }
-  if (xte_count) {
-    do {
-      xte_count--;
-      free_xte(xte_recs+xte_count);
-    } while (xte_count);
-  }
-  xfree(xte_recs);
+  xte_count = 0;
+  xte_recs.clear();
+  xte_heap.clear();
+
+  (*waypt_del_marked_fnp)(const_cast<route_head*>(rte));
 }
 
 void SimplifyRouteFilter::process()
@@ -314,10 +366,10 @@ void SimplifyRouteFilter::process()
   RteHdFunctor<SimplifyRouteFilter> routesimple_head_f(this, &SimplifyRouteFilter::routesimple_head);
   RteHdFunctor<SimplifyRouteFilter> routesimple_tail_f(this, &SimplifyRouteFilter::routesimple_tail);
 
-  waypt_del_fnp = route_del_wpt;
+  waypt_del_marked_fnp = route_del_marked_wpts;
   route_disp_all(routesimple_head_f, routesimple_tail_f, routesimple_waypt_pr_f);
 
-  waypt_del_fnp = track_del_wpt;
+  waypt_del_marked_fnp = track_del_marked_wpts;
   track_disp_all(routesimple_head_f, routesimple_tail_f, routesimple_waypt_pr_f);
 }
 
@@ -328,10 +380,10 @@ void SimplifyRouteFilter::init()
   if (!!countopt == !!erroropt) {
     fatal(MYNAME ": You must specify either count or error, but not both.\n");
   }
-  if ((!!xteopt + !!lenopt + !!relopt) > 1) {
-    fatal(MYNAME ": You may specify only one of crosstrack, length, or relative.\n");
+  if ((!!xteopt + !!lenopt + !!relopt + !!visopt) > 1) {
+    fatal(MYNAME ": You may specify only one of crosstrack, length, relative, or visvalingam.\n");
   }
-  if (!xteopt && !lenopt && !relopt) {
+  if (!xteopt && !lenopt && !relopt && !visopt) {
     xteopt = (char*) "";
   }
 
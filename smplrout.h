@@ -48,6 +48,10 @@
  * too, is only a heuristic, as it's possible that a different combination or
  * order of point removals could lead to a smaller number of points with less
  * reduction in path length.  In the case of pathlength, error is cumulative.
+ *
+ * The effective area (Visvalingam-Whyatt) metric works the same way, using
+ * the area of the triangle ABC instead of its height.  To keep the error
+ * option in units of distance, the metric is the square root of that area.
 */
 
 /*
@@ -59,6 +63,8 @@
 #ifndef SMPLROUT_H_INCLUDED_
 #define SMPLROUT_H_INCLUDED_
 
+#include <QtCore/QVector>  // for QVector
+
 #include "defs.h"    // for route_head (ptr only), Waypoint (ptr only), ARGT...
 #include "filter.h"  // for Filter
 
@@ -85,9 +91,10 @@ private:
   char* xteopt;
   char* lenopt;
   char* relopt;
-  void (*waypt_del_fnp)(route_head* rte, Waypoint* wpt);
+  char* visopt;
+  void (*waypt_del_marked_fnp)(route_head* rte);
 
-  arglist_t args[6] = {
+  arglist_t args[7] = {
     {
       "count", &countopt,  "Maximum number of points in route",
       nullptr, ARGTYPE_INT | ARGTYPE_BEGIN_REQ | ARGTYPE_BEGIN_EXCL, "1", nullptr, nullptr
@@ -106,38 +113,54 @@ private:
     },
     {
       "relative", &relopt, "Use relative error", nullptr,
+      ARGTYPE_BOOL, ARG_NOMINMAX, nullptr
+    },
+    {
+      "visvalingam", &visopt, "Use effective area (Visvalingam-Whyatt)", nullptr,
       ARGTYPE_BOOL | ARGTYPE_END_EXCL, ARG_NOMINMAX, nullptr
     },
     ARG_TERMINATOR
   };
 
-  struct xte_intermed;
-
+  /*
+   * One record per point.  The records form a doubly linked list in
+   * route order (through prev and next), and each has an entry in an
+   * indexed binary heap ordered by removal preference.  The heap entries
+   * carry their own copy of the sort key so that sifting doesn't have to
+   * chase pointers.
+   */
   struct xte {
     double distance;
-    int ordinal;
-    struct xte_intermed* intermed;
-  };
-
-  struct xte_intermed {
-    struct xte* xte_rec;
-    struct xte_intermed* next;
-    struct xte_intermed* prev;
+    int prev;
+    int next;
+    int heap_pos;
+    int tiebreak;
     const Waypoint* wpt;
   };
 
-  void free_xte(struct xte* xte_rec);
+  struct xte_heap_entry {
+    double distance;
+    int priority;
+    int tiebreak;
+    int rec;
+  };
 
-  struct xte_intermed* tmpprev = nullptr;
   int xte_count = 0;
   const route_head* cur_rte = nullptr;
-  struct xte* xte_recs = nullptr;
+  QVector<xte> xte_recs;
+  QVector<xte_heap_entry> xte_heap;
+  int tiebreak_lo = 0;
+  int tiebreak_hi = 0;
 
   void routesimple_waypt_pr(const Waypoint* wpt);
-  void compute_xte(struct xte* xte_rec);
-  static int compare_xte(const void* a, const void* b);
+  void compute_xte(xte& xte_rec);
+  static bool xte_before(const xte_heap_entry& a, const xte_heap_entry& b);
+  void xte_heap_place(int i, const xte_heap_entry& entry);
+  void xte_heap_up(int i);
+  void xte_heap_down(int i);
+  void xte_heap_update(int rec);
+  int xte_heap_pop();
   void routesimple_head(const route_head* rte);
-  void shuffle_xte(struct xte* xte_rec);
   void routesimple_tail(const route_head* rte);
 
 };
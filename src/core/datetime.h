@@ -28,6 +28,7 @@
 #include <QtCore/QtGlobal>
 #include <QtCore/QDateTime>
 #include <QtCore/QString>
+#include <QtCore/QVector>
 
 // As this code began in C, we have several hundred places that set and
 // read creation_time as a time_t.  Provide some operator overloads to make
@@ -90,6 +91,174 @@ public:
   }
 };
 
+// A compact stand-in for DateTime for places that keep one per point,
+// i.e. Waypoint::creation_time.  It is a single word: milliseconds since
+// the epoch, scaled up to make room for a tag in the low byte that says
+// how to rebuild the equivalent QDateTime.  So the accessors used in per
+// point loops are plain integer arithmetic, there is no QDateTime private
+// behind it, and it is no bigger than the QDateTime it replaces.
+// Anything else goes through a conversion to DateTime.
+class PackedDateTime {
+public:
+  // Like DateTime(), 1/1/1970 local time.
+  PackedDateTime() = default;
+
+  PackedDateTime(const QDateTime& dt) {
+    if (!dt.isValid()) {
+      word = kInvalid;
+      return;
+    }
+    qint64 msecs = dt.toMSecsSinceEpoch();
+    if ((msecs < kMinMSecs) || (msecs > kMaxMSecs)) {
+      // more than a million years out, nothing we read means that.
+      word = kInvalid;
+      return;
+    }
+    int tag;
+    switch (dt.timeSpec()) {
+    case Qt::LocalTime:
+      tag = kLocalTime;
+      break;
+    case Qt::UTC:
+      tag = kUTC;
+      break;
+    default:
+      // Qt::TimeZone is kept as its offset at this instant.
+      tag = offset_tag(dt.offsetFromUtc());
+      break;
+    }
+    word = msecs * kTags + tag;
+  }
+
+  operator DateTime() const {
+    switch (tag()) {
+    case kLocalTime:
+      return QDateTime::fromMSecsSinceEpoch(msecs(), Qt::LocalTime);
+    case kUTC:
+      return QDateTime::fromMSecsSinceEpoch(msecs(), Qt::UTC);
+    case kInvalid:
+      return QDateTime();
+    default:
+      return QDateTime::fromMSecsSinceEpoch(msecs(), Qt::OffsetFromUTC,
+                                            offsets().at(tag() - kFirstOffset));
+    }
+  }
+
+  // Same answer as DateTime::isValid(), time_t 0 included.
+  bool isValid() const {
+    return (word != kInvalid) && (toTime_t() > 0);
+  }
+
+  // Same range handling as QDateTime::toTime_t().
+  uint toTime_t() const {
+    if (word == kInvalid) {
+      return uint(-1);
+    }
+    qint64 secs = msecs() / 1000;
+    if (quint64(secs) >= Q_UINT64_C(0xFFFFFFFF)) {
+      return uint(-1);
+    }
+    return uint(secs);
+  }
+
+  qint64 toMSecsSinceEpoch() const {
+    return msecs();
+  }
+
+  qint64 msecsTo(const PackedDateTime& other) const {
+    if ((word == kInvalid) || (other.word == kInvalid)) {
+      return 0;
+    }
+    return other.msecs() - msecs();
+  }
+
+  PackedDateTime addMSecs(qint64 ms) const {
+    PackedDateTime result(*this);
+    if (word != kInvalid) {
+      result.word += ms * kTags;
+    }
+    return result;
+  }
+
+  PackedDateTime addSecs(qint64 s) const {
+    return addMSecs(s * 1000);
+  }
+
+  // Keeps the time spec, like QDateTime::setTime_t().
+  void setTime_t(uint t) {
+    int tg = (word == kInvalid) ? int(kLocalTime) : tag();
+    word = qint64(t) * 1000 * kTags + tg;
+  }
+
+  PackedDateTime& operator+=(const time_t& t) {
+    *this = addSecs(t);
+    return *this;
+  }
+
+  bool operator==(const PackedDateTime& other) const {
+    return ((word == kInvalid) == (other.word == kInvalid)) && (msecs() == other.msecs());
+  }
+  bool operator!=(const PackedDateTime& other) const {
+    return !(*this == other);
+  }
+  bool operator<(const PackedDateTime& other) const {
+    return msecs() < other.msecs();
+  }
+  bool operator>(const PackedDateTime& other) const {
+    return other < *this;
+  }
+  bool operator<=(const PackedDateTime& other) const {
+    return !(other < *this);
+  }
+  bool operator>=(const PackedDateTime& other) const {
+    return !(*this < other);
+  }
+
+private:
+  // The low byte of word.  Offsets from UTC are few in practice, so they
+  // are kept once in a table and the tag indexes it.
+  enum {
+    kLocalTime = 0,
+    kUTC = 1,
+    kInvalid = 2,
+    kFirstOffset = 3,
+    kTags = 256
+  };
+  static constexpr qint64 kMaxMSecs = (Q_INT64_C(1) << 55) - 1;
+  static constexpr qint64 kMinMSecs = -kMaxMSecs;
+
+  int tag() const {
+    return int(word & (kTags - 1));
+  }
+
+  qint64 msecs() const {
+    return (word - tag()) / kTags;
+  }
+
+  static QVector<int>& offsets() {
+    static QVector<int> table;
+    return table;
+  }
+
+  static int offset_tag(int offset) {
+    QVector<int>& table = offsets();
+    int idx = table.indexOf(offset);
+    if (idx < 0) {
+      if (table.size() >= kTags - kFirstOffset) {
+        // Out of tags, keep the instant and fall back to UTC.
+        return kUTC;
+      }
+      table.append(offset);
+      idx = table.size() - 1;
+    }
+    return kFirstOffset + idx;
+  }
+
+  qint64 word{0};	// msecs * kTags + tag
+};
+
+static_assert(sizeof(PackedDateTime) == sizeof(qint64), "PackedDateTime should be one word");
+
 } // namespace gpsbabel
 
 #endif // DATETIME_H_INCLUDED_
@@ -0,0 +1,118 @@
+/*
+    Copyright (C) 2019 Robert Lipe, gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+ */
+
+#include <cmath>               // for fabs, floor, fma, isfinite, signbit
+#include <cstdint>             // for uint64_t, uint32_t
+
+#include <QtCore/QByteArray>   // for QByteArray
+#include <QtCore/QString>      // for QString
+
+#include "src/core/numberformat.h"
+
+
+namespace gpsbabel
+{
+
+static const uint32_t kPow10[] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+int formatFixedFast(char* buf, double d, int precision)
+{
+  if (precision < 1 || precision > 9 || !std::isfinite(d)) {
+    return -1;
+  }
+  const bool negative = std::signbit(d);
+  const double a = std::fabs(d);
+  if (a >= 1e15) {
+    return -1;
+  }
+
+  /*
+   * Split into integer and fraction; both are exact for |d| < 2^53.
+   * The scaled fraction is rounded by the multiply, but fma gives us the
+   * rounding error exactly, which is all we need to decide whether the
+   * true value is above, below or exactly on the halfway point.  Qt
+   * (via double-conversion) rounds halfway cases away from zero.
+   */
+  auto ip = static_cast<uint64_t>(a);
+  const double frac = a - static_cast<double>(ip);
+  const double scale = kPow10[precision];
+  const double p = frac * scale;
+  const double err = std::fma(frac, scale, -p);
+  const double pfloor = std::floor(p);
+  const double r = p - pfloor;
+  auto q = static_cast<uint32_t>(pfloor);
+  if (r > 0.5 || (r == 0.5 && err >= 0.0)) {
+    q++;
+  }
+  if (q >= kPow10[precision]) {
+    q -= kPow10[precision];
+    ip++;
+  }
+
+  if (negative && ip == 0 && q == 0) {
+    return -1;
+  }
+
+  char digits[20];
+  int ndigits = 0;
+  do {
+    digits[ndigits++] = static_cast<char>('0' + ip % 10);
+    ip /= 10;
+  } while (ip != 0);
+
+  char* out = buf;
+  if (negative) {
+    *out++ = '-';
+  }
+  while (ndigits > 0) {
+    *out++ = digits[--ndigits];
+  }
+  *out++ = '.';
+  for (int i = precision - 1; i >= 0; i--) {
+    out[i] = static_cast<char>('0' + q % 10);
+    q /= 10;
+  }
+  out += precision;
+  return static_cast<int>(out - buf);
+}
+
+void appendFixed(QByteArray& out, double d, int precision)
+{
+  char buf[kFormatFixedMaxLength];
+  int len = formatFixedFast(buf, d, precision);
+  if (len < 0) {
+    out.append(QByteArray::number(d, 'f', precision));
+  } else {
+    out.append(buf, len);
+  }
+}
+
+QString formatFixed(double d, int precision)
+{
+  char buf[kFormatFixedMaxLength];
+  int len = formatFixedFast(buf, d, precision);
+  if (len < 0) {
+    return QString::number(d, 'f', precision);
+  }
+  return QString::fromLatin1(buf, len);
+}
+
+} // namespace
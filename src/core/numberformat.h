@@ -0,0 +1,53 @@
+/*
+    Copyright (C) 2019 Robert Lipe, gpsbabel.org
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+ */
+
+#ifndef NUMBERFORMAT_H
+#define NUMBERFORMAT_H
+
+#include <QtCore/QByteArray>  // for QByteArray
+#include <QtCore/QString>     // for QString
+
+namespace gpsbabel
+{
+
+/*
+ * Fixed point formatting of doubles that produces exactly the text of
+ * QString::number(d, 'f', precision), without the temporary QStrings
+ * that Qt builds along the way.  Writers emit a handful of these per
+ * point, so for large tracks this is a noticeable part of output time.
+ *
+ * Values the fast path doesn't handle (non-finite, very large, precision
+ * outside 1..9, negative values that round to zero) are handed to Qt.
+ */
+
+// Longest text formatFixedFast() can produce.
+const int kFormatFixedMaxLength = 32;
+
+// Writes d into buf and returns the length, or -1 if d needs Qt.
+int formatFixedFast(char* buf, double d, int precision);
+
+// Appends d to out.
+void appendFixed(QByteArray& out, double d, int precision);
+
+// Same as QString::number(d, 'f', precision).
+QString formatFixed(double d, int precision);
+
+} // namespace
+
+#endif // NUMBERFORMAT_H
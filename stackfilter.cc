@@ -40,22 +40,27 @@ void StackFilter::process()
     tmp_elt->next = stack;
     stack = tmp_elt;
 
-    waypt_list_ptr = &(tmp_elt->waypts);
-    waypt_backup(&waypt_list_ptr);
-    if (!opt_copy) {
+    /*
+     * Without copy, ownership of the lists simply moves onto the stack.
+     * With copy, the entry gets its own points; their strings stay
+     * shared with the originals until one side changes them.
+     */
+    if (opt_copy) {
+      waypt_list_ptr = &(tmp_elt->waypts);
+      waypt_backup(&waypt_list_ptr);
+
+      route_list_ptr = &(tmp_elt->routes);
+      route_backup(&route_list_ptr);
+
+      route_list_ptr = &(tmp_elt->tracks);
+      track_backup(&route_list_ptr);
+    } else {
+      waypt_swap(tmp_elt->waypts);
       waypt_flush_all();
-    }
 
-    route_list_ptr = &(tmp_elt->routes);
-    route_backup(&route_list_ptr);
-    if (!opt_copy) {
-      route_flush_all_routes();
-    }
+      route_swap(tmp_elt->routes);
 
-    route_list_ptr = &(tmp_elt->tracks);
-    track_backup(&route_list_ptr);
-    if (!opt_copy) {
-      route_flush_all_tracks();
+      track_swap(tmp_elt->tracks);
     }
 
   } else if (opt_pop) {
@@ -65,11 +70,8 @@ void StackFilter::process()
     }
     if (opt_append) {
       waypt_append(&(stack->waypts));
-      stack->waypts.flush();
       route_append(&(stack->routes));
-      stack->routes.flush();
       track_append(&(stack->tracks));
-      stack->tracks.flush();
     } else if (opt_discard) {
       stack->waypts.flush();
       stack->routes.flush();
@@ -469,7 +469,7 @@ calculate(const Waypoint* wpt, double* dist, double* speed, double* course,
       *dist = 0;  /* calc. diffs on 32- and 64-bit hosts */
     }
 
-    time_t time = wpt->creation_time.toTime_t() - trkpt_out->GetCreationTime().toTime_t();
+    time_t time = wpt->creation_time.toTime_t() - trkpt_out->creation_time.toTime_t();
     if (time == 0) {
       *speed = 0;
     } else {
@@ -540,7 +540,7 @@ any_waypt_calc_cb(const Waypoint* wpt)
   }
 
   if ((all_points == 0) && (this_points == 0)) {
-    start_time = wpt->GetCreationTime().toTime_t();
+    start_time = wpt->creation_time.toTime_t();
   }
 
   this_points++;
@@ -558,7 +558,7 @@ any_waypt_calc_cb(const Waypoint* wpt)
 
   this_distance = this_distance + dist;
   if (trkpt_out != nullptr) {
-    this_time += (wpt->GetCreationTime().toTime_t() - trkpt_out->GetCreationTime().toTime_t());
+    this_time += (wpt->creation_time.toTime_t() - trkpt_out->creation_time.toTime_t());
   }
 
   trkpt_out = wpt;
@@ -599,7 +599,7 @@ track_disp_wpt_cb(const Waypoint* wpt)
   track_points++;
   all_track_points++;
 
-  time_t ct = wpt->GetCreationTime().toTime_t();
+  time_t ct = wpt->creation_time.toTime_t();
   tm = *localtime(&ct);
   strftime(tbuf, sizeof(tbuf), "%d.%m.%Y,%H:%M.%S", &tm);
 
@@ -682,8 +682,8 @@ route_disp_wpt_cb(const Waypoint* wpt)
 static void
 track_disp_custom_cb(const Waypoint* wpt)
 {
-  if (wpt->GetCreationTime().isValid() && (wpt->altitude != unknown_alt)) {
-    gbfprintf(fout, "%d,%.f\n", (int)(wpt->GetCreationTime().toTime_t() - start_time), wpt->altitude);
+  if (wpt->creation_time.isValid() && (wpt->altitude != unknown_alt)) {
+    gbfprintf(fout, "%d,%.f\n", (int)(wpt->creation_time.toTime_t() - start_time), wpt->altitude);
   }
 }
 
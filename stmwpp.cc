@@ -236,7 +236,7 @@ stmwpp_waypt_cb(const Waypoint* wpt)
     return;
   }
 
-  const time_t tt = wpt->GetCreationTime().toTime_t();
+  const time_t tt = wpt->creation_time.toTime_t();
   struct tm tm = *gmtime(&tt);
   tm.tm_year += 1900;
   tm.tm_mon++;
@@ -67,7 +67,7 @@ subrip_prevwp_pr(const Waypoint* waypointp)
   /* If this condition is not true, the waypoint is before the beginning of
    * the video and will be ignored
    */
-  if (prevwpp->GetCreationTime().toTime_t() < time_offset) {
+  if (prevwpp->creation_time.toTime_t() < time_offset) {
     return;
   }
 
@@ -180,7 +180,7 @@ subrip_trkpt_pr(const Waypoint* waypointp)
      * way of solving this should be trivial to you :-)
      */
   {
-    time_offset = sync_time(waypointp->GetCreationTime().toTime_t(), opt_videotime);
+    time_offset = sync_time(waypointp->creation_time.toTime_t(), opt_videotime);
   }
 
   if (prevwpp) {
@@ -23,7 +23,7 @@
 #undef TRACKF_DBG
 
 #include <cassert>                         // for assert
-#include <cmath>                           // for nan
+#include <cmath>                           // for abs
 #include <cstdio>                          // for printf
 #include <cstdlib>                         // for abs
 #include <cstring>                         // for strlen, strchr, strcmp
@@ -534,7 +534,7 @@ void TrackFilter::trackfilter_split()
         }
 
         if (interval > 0) {
-          double tr_interval = 0.001 * buff.at(i)->GetCreationTime().msecsTo(buff.at(j)->GetCreationTime());
+          double tr_interval = 0.001 * buff.at(i)->creation_time.msecsTo(buff.at(j)->creation_time);
           if (tr_interval <= interval) {
             new_track_flag = false;
           }
@@ -585,73 +585,71 @@ void TrackFilter::trackfilter_move()
 * options "fix", "course", "speed"
 *******************************************************************************/
 
-void TrackFilter::trackfilter_synth()
+void TrackFilter::trackfilter_synth_wpt(Waypoint* wpt)
 {
-  double last_course_lat;
-  double last_course_lon;
-  double last_speed_lat = std::nan(""); /* Quiet gcc 7.3.0 -Wmaybe-uninitialized */
-  double last_speed_lon = std::nan(""); /* Quiet gcc 7.3.0 -Wmaybe-uninitialized */
-  gpsbabel::DateTime last_speed_time;
-  int nsats = 0;
+  if (opt_fix) {
+    wpt->fix = synth.fix;
+    if (wpt->sat == 0) {
+      wpt->sat = synth.nsats;
+    }
+  }
+  if (synth.first) {
+    if (opt_course) {
+      // TODO: the course value 0 isn't valid, wouldn't it be better to UNSET course?
+      WAYPT_SET(wpt, course, 0);
+    }
+    if (opt_speed) {
+      // TODO: the speed value 0 isn't valid, wouldn't it be better to UNSET speed?
+      WAYPT_SET(wpt, speed, 0);
+    }
+    synth.first = false;
+    synth.last_course_lat = wpt->latitude;
+    synth.last_course_lon = wpt->longitude;
+    synth.last_speed_lat = wpt->latitude;
+    synth.last_speed_lon = wpt->longitude;
+    synth.last_speed_time = wpt->GetCreationTime();
+  } else {
+    if (opt_course) {
+      WAYPT_SET(wpt, course, heading_true_degrees(RAD(synth.last_course_lat),
+                RAD(synth.last_course_lon),RAD(wpt->latitude),
+                RAD(wpt->longitude)));
+      synth.last_course_lat = wpt->latitude;
+      synth.last_course_lon = wpt->longitude;
+    }
+    if (opt_speed) {
+      if (synth.last_speed_time.msecsTo(wpt->GetCreationTime()) != 0) {
+        // If we have multiple points with the same time and
+        // we use the pair of points about which the time ticks then we will
+        // underestimate the distance and compute low speeds on average.
+        // Therefore, if we have multiple points with the same time use the
+        // first ones with the new times to compute speed.
+        // Note that points with the same time can occur because the input
+        // has truncated times, or because we are truncating times with
+        // toTime_t().
+        WAYPT_SET(wpt, speed, radtometers(gcdist(
+                                            RAD(synth.last_speed_lat), RAD(synth.last_speed_lon),
+                                            RAD(wpt->latitude),
+                                            RAD(wpt->longitude))) /
+                  (0.001 * std::abs(synth.last_speed_time.msecsTo(wpt->GetCreationTime())))
+                 );
+        synth.last_speed_lat = wpt->latitude;
+        synth.last_speed_lon = wpt->longitude;
+        synth.last_speed_time = wpt->GetCreationTime();
+      } else {
+        WAYPT_UNSET(wpt, speed);
+      }
+    }
+  }
+}
 
-  fix_type fix = trackfilter_parse_fix(&nsats);
+void TrackFilter::trackfilter_synth()
+{
+  synth.fix = trackfilter_parse_fix(&synth.nsats);
 
   for (auto track : qAsConst(track_list)) {
-    bool first = true;
+    synth.first = true;
     foreach (Waypoint* wpt, track->waypoint_list) {
-      if (opt_fix) {
-        wpt->fix = fix;
-        if (wpt->sat == 0) {
-          wpt->sat = nsats;
-        }
-      }
-      if (first) {
-        if (opt_course) {
-          // TODO: the course value 0 isn't valid, wouldn't it be better to UNSET course?
-          WAYPT_SET(wpt, course, 0);
-        }
-        if (opt_speed) {
-          // TODO: the speed value 0 isn't valid, wouldn't it be better to UNSET speed?
-          WAYPT_SET(wpt, speed, 0);
-        }
-        first = false;
-        last_course_lat = wpt->latitude;
-        last_course_lon = wpt->longitude;
-        last_speed_lat = wpt->latitude;
-        last_speed_lon = wpt->longitude;
-        last_speed_time = wpt->GetCreationTime();
-      } else {
-        if (opt_course) {
-          WAYPT_SET(wpt, course, heading_true_degrees(RAD(last_course_lat),
-                    RAD(last_course_lon),RAD(wpt->latitude),
-                    RAD(wpt->longitude)));
-          last_course_lat = wpt->latitude;
-          last_course_lon = wpt->longitude;
-        }
-        if (opt_speed) {
-          if (last_speed_time.msecsTo(wpt->GetCreationTime()) != 0) {
-            // If we have multiple points with the same time and
-            // we use the pair of points about which the time ticks then we will
-            // underestimate the distance and compute low speeds on average.
-            // Therefore, if we have multiple points with the same time use the
-            // first ones with the new times to compute speed.
-            // Note that points with the same time can occur because the input
-            // has truncated times, or because we are truncating times with
-            // toTime_t().
-            WAYPT_SET(wpt, speed, radtometers(gcdist(
-                                                RAD(last_speed_lat), RAD(last_speed_lon),
-                                                RAD(wpt->latitude),
-                                                RAD(wpt->longitude))) /
-                      (0.001 * std::abs(last_speed_time.msecsTo(wpt->GetCreationTime())))
-                     );
-            last_speed_lat = wpt->latitude;
-            last_speed_lon = wpt->longitude;
-            last_speed_time = wpt->GetCreationTime();
-          } else {
-            WAYPT_UNSET(wpt, speed);
-          }
-        }
-      }
+      trackfilter_synth_wpt(wpt);
     }
   }
 }
@@ -991,6 +989,72 @@ void TrackFilter::deinit()
   track_list.clear();
 }
 
+/*******************************************************************************
+* streaming: options "name", "move", "fix", "course" and "speed" only
+*******************************************************************************/
+
+bool TrackFilter::stream_capable()
+{
+  int opts = trackfilter_opt_count();
+  if (opts == 0) {
+    return false;  /* "pack" by default */
+  }
+
+  for (const char* opt : {opt_name, opt_move, opt_fix, opt_course, opt_speed}) {
+    if (opt != nullptr) {
+      opts--;
+    }
+  }
+  return opts == 0;
+}
+
+bool TrackFilter::stream_track(const route_head* track)
+{
+  stream_skip = true;
+  if (track->rte_waypt_ct == 0) {
+    return false;
+  }
+  if (opt_name != nullptr) {
+    if (!QRegExp(opt_name, Qt::CaseInsensitive, QRegExp::WildcardUnix).exactMatch(track->rte_name)) {
+      return false;
+    }
+  }
+  stream_skip = false;
+
+  stream_prev_time = gpsbabel::DateTime();
+  stream_delta = (opt_move != nullptr) ? trackfilter_parse_time_opt(opt_move) : 0;
+  synth.fix = trackfilter_parse_fix(&synth.nsats);
+  synth.first = true;
+  return true;
+}
+
+bool TrackFilter::stream_point(Waypoint* wpt)
+{
+  if (stream_skip) {
+    return false;
+  }
+
+  /* the checks of trackfilter_fill_track_list_cb */
+  if (need_time && (!wpt->creation_time.isValid())) {
+    fatal(MYNAME "-init: Found track point at %f,%f without time!\n",
+          wpt->latitude, wpt->longitude);
+  }
+  if (need_time && stream_prev_time.isValid() && (stream_prev_time > wpt->GetCreationTime())) {
+    QString t1 = stream_prev_time.toPrettyString();
+    QString t2 = wpt->CreationTimeXML();
+    fatal(MYNAME "-init: Track points badly ordered (timestamp %s > %s)!\n", qPrintable(t1), qPrintable(t2));
+  }
+  stream_prev_time = wpt->GetCreationTime();
+
+  if (stream_delta != 0) {
+    wpt->creation_time = wpt->creation_time.addSecs(stream_delta);
+  }
+  if (opt_speed || opt_course || opt_fix) {
+    trackfilter_synth_wpt(wpt);
+  }
+  return true;
+}
+
 /*******************************************************************************
 * trackfilter_process: called from gpsbabel central engine
 *******************************************************************************/
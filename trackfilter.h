@@ -28,6 +28,7 @@
 
 #include "defs.h"            // for ARG_NOMINMAX, route_head (ptr only), ARG...
 #include "filter.h"          // for Filter
+#include "src/core/datetime.h"  // for DateTime
 
 #if FILTERS_ENABLED || MINIMAL_FILTERS
 
@@ -60,6 +61,9 @@ public:
   void init() override;
   void process() override;
   void deinit() override;
+  bool stream_capable() override;
+  bool stream_track(const route_head* track) override;
+  bool stream_point(Waypoint* wpt) override;
 
 private:
   char* opt_merge = nullptr;
@@ -200,8 +204,25 @@ private:
 
   void trackfilter_move();
 
+  struct synth_t {
+    fix_type fix{fix_unknown};
+    int nsats{0};
+    bool first{true};
+    double last_course_lat{0};
+    double last_course_lon{0};
+    double last_speed_lat{0};
+    double last_speed_lon{0};
+    gpsbabel::DateTime last_speed_time;
+  };
+
+  synth_t synth;
+  void trackfilter_synth_wpt(Waypoint* wpt);
   void trackfilter_synth();
 
+  bool stream_skip{false};
+  qint64 stream_delta{0};
+  gpsbabel::DateTime stream_prev_time;
+
   QDateTime trackfilter_range_check(const char* timestr);
   void trackfilter_range();
 
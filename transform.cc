@@ -23,7 +23,7 @@
 #include <cctype>           // for toupper
 #include <cstdlib>          // for atoi
 
-#include <QtCore/QtGlobal>  // for foreach
+#include <QtCore/QtGlobal>  // for foreach, qAsConst
 
 #include "defs.h"
 #include "filterdefs.h"
@@ -77,6 +77,17 @@ void TransformFilter::transform_rte_disp_hdr_cb(const route_head* rte)
   }
 }
 
+route_head* TransformFilter::transform_trk_rte_alloc(const route_head* trk)
+{
+  route_head* rte = route_head_alloc();
+  if (!trk->rte_name.isEmpty()) {
+    rte->rte_desc = "Generated from track ";
+    rte->rte_desc += trk->rte_name;
+    rte->rte_name = trk->rte_name; /* name the new rte */
+  }
+  return rte;
+}
+
 void TransformFilter::transform_trk_disp_hdr_cb(const route_head* trk)
 {
   current_namepart = RPT;
@@ -84,13 +95,8 @@ void TransformFilter::transform_trk_disp_hdr_cb(const route_head* trk)
     current_namepart = trk->rte_name;
   }
   if (current_target == 'R') {
-    current_rte = route_head_alloc();
+    current_rte = transform_trk_rte_alloc(trk);
     route_add_head(current_rte);
-    if (!trk->rte_name.isEmpty()) {
-      current_rte->rte_desc = "Generated from track ";
-      current_rte->rte_desc += trk->rte_name;
-      current_rte->rte_name = trk->rte_name; /* name the new rte */
-    }
   }
 }
 
@@ -119,16 +125,90 @@ void TransformFilter::transform_tracks()
   WayptFunctor<TransformFilter> transform_any_disp_wpt_cb_f(this, &TransformFilter::transform_any_disp_wpt_cb);
   RteHdFunctor<TransformFilter> transform_trk_disp_hdr_cb_f(this, &TransformFilter::transform_trk_disp_hdr_cb);
 
-  track_disp_all(transform_trk_disp_hdr_cb_f, nullptr, transform_any_disp_wpt_cb_f);
+  if (!streamed) {
+    track_disp_all(transform_trk_disp_hdr_cb_f, nullptr, transform_any_disp_wpt_cb_f);
+    return;
+  }
+
+  /* The tracks are gone, add what was taken from them on the way. */
+  if (current_target == 'W') {
+    for (auto* wpt : qAsConst(stream_wpts)) {
+      waypt_add(wpt);
+    }
+    stream_wpts.clear();
+  } else if (current_target == 'R') {
+    for (const auto& rte : qAsConst(stream_rtes)) {
+      route_add_head(rte.head);
+      for (auto* wpt : rte.wpts) {
+        route_add_wpt(rte.head, wpt, rte.namepart, name_digits);
+      }
+    }
+    stream_rtes.clear();
+  }
+}
+
+/*******************************************************************************
+* streaming: the tracks are taken as they come, anything made from them is
+* added to the lists in stream_finish(), in the order process() would.
+*******************************************************************************/
+
+bool TransformFilter::stream_capable()
+{
+  return opt_tracks == nullptr;
+}
+
+bool TransformFilter::stream_track(const route_head* trk)
+{
+  bool from_tracks = false;
+
+  if ((opt_waypts != nullptr) && (toupper(*opt_waypts) == 'T')) {
+    from_tracks = true;
+  }
+  stream_to_rte = false;
+  if ((opt_routes != nullptr) && (toupper(*opt_routes) == 'T')) {
+    from_tracks = true;
+    /* unless the tracks are already deleted for "wpt" */
+    stream_to_rte = !(delete_after && (opt_waypts != nullptr) && (toupper(*opt_waypts) == 'T'));
+  }
+  if (stream_to_rte) {
+    stream_rte_t rte;
+    rte.head = transform_trk_rte_alloc(trk);
+    rte.namepart = RPT;
+    if (!trk->rte_name.isEmpty() && use_src_name) {
+      rte.namepart = trk->rte_name;
+    }
+    stream_rtes.append(rte);
+  }
+
+  stream_delete = from_tracks && delete_after;
+  return !stream_delete;
+}
+
+bool TransformFilter::stream_point(Waypoint* wpt)
+{
+  if ((opt_waypts != nullptr) && (toupper(*opt_waypts) == 'T')) {
+    stream_wpts.append(new Waypoint(*wpt));
+  }
+  if (stream_to_rte) {
+    stream_rtes.last().wpts.append(new Waypoint(*wpt));
+  }
+  return !stream_delete;
+}
+
+void TransformFilter::stream_finish()
+{
+  streamed = true;
+  process();
+  streamed = false;
 }
 
 /*******************************************************************************
 * %%%        global callbacks called by gpsbabel main process              %%% *
 *******************************************************************************/
 
-void TransformFilter::process()
+void TransformFilter::init()
 {
-  int delete_after = (opt_delete && (*opt_delete == '1')) ? 1 : 0;
+  delete_after = (opt_delete && (*opt_delete == '1')) ? 1 : 0;
 
   use_src_name = (opt_rpt_name && (*opt_rpt_name == '1')) ? 1 : 0;
 
@@ -136,7 +216,10 @@ void TransformFilter::process()
   if (rpt_name_digits && *rpt_name_digits) {
     name_digits = atoi(rpt_name_digits);
   }
+}
 
+void TransformFilter::process()
+{
   if (opt_waypts != nullptr) {
     current_target = 'W';
     switch (toupper(*opt_waypts)) {
@@ -196,4 +279,19 @@ void TransformFilter::process()
   }
 }
 
+void TransformFilter::deinit()
+{
+  for (auto* wpt : qAsConst(stream_wpts)) {
+    delete wpt;
+  }
+  stream_wpts.clear();
+  for (const auto& rte : qAsConst(stream_rtes)) {
+    for (auto* wpt : rte.wpts) {
+      delete wpt;
+    }
+    delete rte.head;
+  }
+  stream_rtes.clear();
+}
+
 #endif // FILTERS_ENABLED
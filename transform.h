@@ -23,6 +23,7 @@
 #ifndef TRANSFORM_H_INCLUDED_
 #define TRANSFORM_H_INCLUDED_
 
+#include <QtCore/QList>    // for QList
 #include <QtCore/QString>  // for QString
 #include "defs.h"          // for route_head (ptr only), ARG_NOMINMAX, ARGTY...
 #include "filter.h"        // for Filter
@@ -36,7 +37,13 @@ public:
   {
     return args;
   }
+  void init() override;
   void process() override;
+  void deinit() override;
+  bool stream_capable() override;
+  bool stream_track(const route_head* trk) override;
+  bool stream_point(Waypoint* wpt) override;
+  void stream_finish() override;
 
 private:
   char current_target;
@@ -46,7 +53,19 @@ private:
   char* opt_routes, *opt_tracks, *opt_waypts, *opt_delete, *rpt_name_digits, *opt_rpt_name;
   QString current_namepart;
 
-  int name_digits, use_src_name;
+  int name_digits, use_src_name, delete_after;
+
+  struct stream_rte_t {
+    route_head* head;
+    QString namepart;
+    QList<Waypoint*> wpts;
+  };
+
+  bool streamed = false;
+  bool stream_to_rte = false;
+  bool stream_delete = false;
+  QList<Waypoint*> stream_wpts;
+  QList<stream_rte_t> stream_rtes;
 
   const QString RPT = "RPT";
 
@@ -80,6 +99,7 @@ private:
 
   void transform_waypoints();
   void transform_rte_disp_hdr_cb(const route_head* rte);
+  route_head* transform_trk_rte_alloc(const route_head* trk);
   void transform_trk_disp_hdr_cb(const route_head* trk);
   void transform_any_disp_wpt_cb(const Waypoint* wpt);
   void transform_routes();
@@ -591,6 +591,13 @@ unicsv_rd_init(const QString& fname)
   }
 }
 
+static bool
+unicsv_rd_stream_capable()
+{
+  /* all lines go to one track */
+  return global_opts.objective == trkdata;
+}
+
 static void
 unicsv_rd_deinit()
 {
@@ -1195,6 +1202,8 @@ unicsv_parse_one_line(const QString& ibuf)
       track_add_head(unicsv_track);
     }
     track_add_wpt(unicsv_track, wpt);
+    /* each line is a point of its own, only the newest one is kept */
+    track_stream_release(unicsv_track, unicsv_track->rte_waypt_ct - 1);
     break;
   default:
     waypt_add(wpt);
@@ -2105,5 +2114,9 @@ ff_vecs_t unicsv_vecs = {
   unicsv_args,
   CET_CHARSET_UTF8, 0
   , NULL_POS_OPS,
-  nullptr
+  nullptr,
+  {
+    unicsv_rd_stream_capable,
+    nullptr, nullptr, nullptr, nullptr
+  }
 };
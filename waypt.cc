@@ -86,6 +86,12 @@ waypt_del(Waypoint* wpt)
   global_waypoint_list->waypt_del(wpt);
 }
 
+void
+waypt_del_marked()
+{
+  global_waypoint_list->waypt_del_marked();
+}
+
 unsigned int
 waypt_count()
 {
@@ -96,8 +102,8 @@ waypt_count()
 void
 waypt_disp(const Waypoint* wpt)
 {
-  if (wpt->GetCreationTime().isValid()) {
-    printf("%s ", qPrintable(wpt->creation_time.toString()));
+  if (wpt->creation_time.isValid()) {
+    printf("%s ", qPrintable(wpt->GetCreationTime().toString()));
   }
   printposn(wpt->latitude,1);
   printposn(wpt->longitude,0);
@@ -199,7 +205,7 @@ waypt_flush_all()
 void
 waypt_append(WaypointList* src)
 {
-  src->copy(&global_waypoint_list);
+  global_waypoint_list->splice(src);
 }
 
 void
@@ -597,7 +603,8 @@ Waypoint::SetCreationTime(const gpsbabel::DateTime& t)
 void
 Waypoint::SetCreationTime(time_t t)
 {
-  creation_time = QDateTime::fromTime_t(t);
+  creation_time = gpsbabel::PackedDateTime();
+  creation_time.setTime_t(t);
 }
 
 void
@@ -716,6 +723,50 @@ WaypointList::del_rte_waypt(Waypoint* wpt)
   removeAt(idx);
 }
 
+int
+WaypointList::waypt_del_marked()
+{
+  return del_marked(false);
+}
+
+int
+WaypointList::del_marked_rte_wpts()
+{
+  return del_marked(true);
+}
+
+/*
+ * Compact the list in place, deleting the marked waypoints.  When
+ * keep_trkseg is set a segment start is handed on to the next surviving
+ * point, just as del_rte_waypt() does one point at a time.
+ */
+int
+WaypointList::del_marked(bool keep_trkseg)
+{
+  const int n = size();
+  int kept = 0;
+  bool pending_trkseg = false;
+
+  for (int i = 0; i < n; ++i) {
+    Waypoint* wpt = at(i);
+    if (wpt->wpt_flags.marked_for_deletion) {
+      pending_trkseg |= wpt->wpt_flags.new_trkseg;
+      delete wpt;
+      continue;
+    }
+    if (keep_trkseg && pending_trkseg) {
+      wpt->wpt_flags.new_trkseg = 1;
+      pending_trkseg = false;
+    }
+    if (kept != i) {
+      (*this)[kept] = wpt;
+    }
+    kept++;
+  }
+  erase(begin() + kept, end());
+  return n - kept;
+}
+
 /*
  *  Makes another pass over the data to compute bounding
  *  box data and populates bounding box information.
@@ -774,11 +825,22 @@ WaypointList::restore(WaypointList* src)
   src->clear();
 }
 
+void
+WaypointList::splice(WaypointList* src)
+{
+  if (src == nullptr || src == this) {
+    return;
+  }
+  reserve(count() + src->count());
+  foreach (Waypoint* wpt, *src) {
+    waypt_add(wpt);
+  }
+  src->clear();
+}
+
 void WaypointList::swap(WaypointList& other)
 {
-  const WaypointList tmp_list = *this;
-  *this = other;
-  other = tmp_list;
+  QList<Waypoint*>::swap(other);
 }
 
 void WaypointList::sort(Compare cmp)
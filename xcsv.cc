@@ -59,6 +59,7 @@
 #include "src/core/datetime.h"     // for DateTime
 #include "src/core/file.h"         // for File
 #include "src/core/logging.h"      // for Warning, Fatal
+#include "src/core/numberformat.h" // for formatFixedFast, kFormatFixedMaxLength
 #include "src/core/optional.h"     // for optional
 #include "strptime.h"              // for strptime
 #include "xcsv.h"
@@ -1143,6 +1144,49 @@ xcsv_resetpathlen(const route_head* head)
   }
 }
 
+/*****************************************************************************/
+/* xcsv_format_double() - QString::sprintf() for a single double.  The     */
+/*                  "%f", "%.Nf" and "%0W.Nf" conversions that nearly every  */
+/*                  style uses skip Qt's printf parser and its temporaries.  */
+/*****************************************************************************/
+static QString
+xcsv_format_double(const QByteArray& printfc, double d)
+{
+  const char* cp = printfc.constData();
+  int width = 0;
+  int precision = 6;
+
+  if (*cp++ != '%') {
+    return QString().sprintf(printfc.constData(), d);
+  }
+  if (*cp == '0') {
+    cp++;
+    while (isdigit(*cp)) {
+      width = width * 10 + (*cp++ - '0');
+    }
+  }
+  if (*cp == '.') {
+    cp++;
+    if (!isdigit(*cp)) {
+      return QString().sprintf(printfc.constData(), d);
+    }
+    precision = *cp++ - '0';
+  }
+  char buf[gpsbabel::kFormatFixedMaxLength];
+  int len;
+  if ((cp[0] != 'f') || (cp[1] != '\0') ||
+      ((len = gpsbabel::formatFixedFast(buf, d, precision)) < 0)) {
+    return QString().sprintf(printfc.constData(), d);
+  }
+
+  QString buff = QString::fromLatin1(buf, len);
+  if (len < width) {
+    // Zeros go between the sign and the digits, as printf does.
+    buff.insert((buf[0] == '-') ? 1 : 0, QString(width - len, '0'));
+  }
+  return buff;
+}
+
 /*****************************************************************************/
 /* xcsv_waypt_pr() - write output file, handling output conversions          */
 /*                  (the output meat)                                        */
@@ -1307,7 +1351,7 @@ xcsv_waypt_pr(const Waypoint* wpt)
       /* LATITUDE CONVERSION***********************************************/
     case XT_LAT_DECIMAL:
       /* latitude as a pure decimal value */
-      buff = QString().sprintf(fmp.printfc.constData(), lat);
+      buff = xcsv_format_double(fmp.printfc, lat);
       break;
     case XT_LAT_DECIMALDIR:
       /* latitude as a decimal value with N/S after it */
@@ -1339,7 +1383,7 @@ xcsv_waypt_pr(const Waypoint* wpt)
       /* LONGITUDE CONVERSIONS*********************************************/
     case XT_LON_DECIMAL:
       /* longitude as a pure decimal value */
-      buff = QString().sprintf(fmp.printfc.constData(), lon);
+      buff = xcsv_format_double(fmp.printfc, lon);
       break;
     case XT_LON_DECIMALDIR:
       /* latitude as a decimal value with N/S after it */
@@ -1441,15 +1485,13 @@ xcsv_waypt_pr(const Waypoint* wpt)
     case XT_ALT_FEET:
       /* altitude in feet as a decimal value */
       if (wpt->altitude != unknown_alt) {
-        buff = QString().sprintf(fmp.printfc.constData(),
-                  METERS_TO_FEET(wpt->altitude));
+        buff = xcsv_format_double(fmp.printfc, METERS_TO_FEET(wpt->altitude));
       }
       break;
     case XT_ALT_METERS:
       /* altitude in meters as a decimal value */
       if (wpt->altitude != unknown_alt) {
-        buff = QString().sprintf(fmp.printfc.constData(),
-                  wpt->altitude);
+        buff = xcsv_format_double(fmp.printfc, wpt->altitude);
       }
       break;
 
@@ -1517,19 +1559,19 @@ xcsv_waypt_pr(const Waypoint* wpt)
       /* TIME CONVERSIONS**************************************************/
     case XT_EXCEL_TIME:
       /* creation time as an excel (double) time */
-      buff = QString().sprintf(fmp.printfc.constData(), TIMET_TO_EXCEL(wpt->GetCreationTime().toTime_t()));
+      buff = QString().sprintf(fmp.printfc.constData(), TIMET_TO_EXCEL(wpt->creation_time.toTime_t()));
       break;
     case XT_TIMET_TIME:
       /* time as a time_t variable */
     {
-      time_t tt = wpt->GetCreationTime().toTime_t();
+      time_t tt = wpt->creation_time.toTime_t();
       buff = QString().sprintf(fmp.printfc.constData(), tt);
     }
     break;
 
     case XT_TIMET_TIME_MS: {
       /* time as a time_t variable in milliseconds */
-      buff = writetime("%ld", wpt->GetCreationTime().toTime_t(), false);
+      buff = writetime("%ld", wpt->creation_time.toTime_t(), false);
       buff += QString().sprintf("%03d", wpt->GetCreationTime().time().msec());
 
     }
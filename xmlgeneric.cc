@@ -26,6 +26,7 @@
 
 #include <QtCore/QByteArray>
 #include <QtCore/QDebug>
+#include <QtCore/QHash>
 #include <QtCore/QTextCodec>
 #include <QtCore/QXmlStreamAttributes>
 #include <QtCore/QXmlStreamReader>
@@ -38,6 +39,19 @@
 static xg_tag_mapping* xg_tag_tbl;
 static QSet<QString> xg_ignore_taglist;
 
+/*
+ * The callbacks, if any, that xg_tag_tbl maps a given tag path to.
+ * Paths are resolved against the (possibly wildcarded) table the first
+ * time they are seen and remembered, so each element costs one hash
+ * lookup instead of a str_match() of every table entry.
+ */
+struct xg_tag_callbacks {
+  xg_callback* start{nullptr};
+  xg_callback* cdata{nullptr};
+  xg_callback* end{nullptr};
+};
+static QHash<QString, xg_tag_callbacks> xg_tag_cache;
+
 static QString rd_fname;
 static QByteArray reader_data;
 static const char* xg_encoding;
@@ -56,22 +70,41 @@ static QTextCodec* codec = utf8_codec;  // Qt has no vanilla ASCII encoding =(
  * xml strains and insulates us from a lot of the grubbiness of expat.
  */
 
-xg_callback*
-xml_tbl_lookup(const QString& tag, xg_cb_type cb_type)
+static xg_callback*
+xml_tbl_lookup(const QByteArray& tag, xg_cb_type cb_type)
 {
   for (xg_tag_mapping* tm = xg_tag_tbl; tm->tag_cb != nullptr; tm++) {
-    if (str_match(CSTR(tag), tm->tag_name) && (cb_type == tm->cb_type)) {
+    if (str_match(tag.constData(), tm->tag_name) && (cb_type == tm->cb_type)) {
       return tm->tag_cb;
     }
   }
   return nullptr;
 }
 
+static xg_tag_callbacks
+xml_tbl_resolve(const QString& tag)
+{
+  auto it = xg_tag_cache.constFind(tag);
+  if (it != xg_tag_cache.constEnd()) {
+    return *it;
+  }
+
+  // First sighting of this path, match it against the table once.
+  const QByteArray utf8_tag = tag.toUtf8();
+  xg_tag_callbacks cbs;
+  cbs.start = xml_tbl_lookup(utf8_tag, cb_start);
+  cbs.cdata = xml_tbl_lookup(utf8_tag, cb_cdata);
+  cbs.end = xml_tbl_lookup(utf8_tag, cb_end);
+  xg_tag_cache.insert(tag, cbs);
+  return cbs;
+}
+
 void
 xml_init(const QString& fname, xg_tag_mapping* tbl, const char* encoding)
 {
   rd_fname = fname;
   xg_tag_tbl = tbl;
+  xg_tag_cache.clear();
   xg_encoding = encoding;
   if (encoding) {
     QTextCodec* tcodec = QTextCodec::codecForName(encoding);
@@ -87,6 +120,7 @@ xml_deinit()
   reader_data.clear();
   rd_fname.clear();
   xg_tag_tbl = nullptr;
+  xg_tag_cache.clear();
   xg_encoding = nullptr;
   codec = utf8_codec;
 }
@@ -100,7 +134,7 @@ xml_consider_ignoring(const QStringRef& name)
 static void
 xml_run_parser(QXmlStreamReader& reader)
 {
-  xg_callback* cb;
+  xg_tag_callbacks cbs;
   QString current_tag;
 
   while (!reader.atEnd()) {
@@ -125,20 +159,19 @@ xml_run_parser(QXmlStreamReader& reader)
       current_tag.append("/");
       current_tag.append(reader.qualifiedName());
 
-      cb = xml_tbl_lookup(current_tag, cb_start);
-      if (cb) {
+      cbs = xml_tbl_resolve(current_tag);
+      if (cbs.start) {
         const QXmlStreamAttributes attrs = reader.attributes();
-        cb(nullptr, &attrs);
+        cbs.start(nullptr, &attrs);
       }
 
-      cb = xml_tbl_lookup(current_tag, cb_cdata);
-      if (cb) {
+      if (cbs.cdata) {
         QString c = reader.readElementText(QXmlStreamReader::IncludeChildElements);
         // readElementText advances the tokenType to QXmlStreamReader::EndElement,
         // thus we will not process the EndElement case as we will issue a readNext first.
         // does a caller ever expect to be able to use both a cb_cdata and a
         // cb_end callback?
-        cb(c, nullptr);
+        cbs.cdata(c, nullptr);
         current_tag.chop(reader.qualifiedName().length() + 1);
       }
       break;
@@ -148,9 +181,9 @@ xml_run_parser(QXmlStreamReader& reader)
         goto readnext;
       }
 
-      cb = xml_tbl_lookup(current_tag, cb_end);
-      if (cb) {
-        cb(reader.name().toString(), nullptr);
+      cbs = xml_tbl_resolve(current_tag);
+      if (cbs.end) {
+        cbs.end(reader.name().toString(), nullptr);
       }
       current_tag.chop(reader.qualifiedName().length() + 1);
       break;